@@ -0,0 +1,58 @@
+
+#include "Arena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+void *Arena::allocate(size_t size, size_t align) {
+    auto cur = reinterpret_cast<uintptr_t>(m_cur);
+    auto aligned = (cur + align - 1) & ~(uintptr_t(align) - 1);
+    if (! m_cur || aligned + size > reinterpret_cast<uintptr_t>(m_end)) {
+        add_block(std::max(BlockSize, size + align));
+        cur = reinterpret_cast<uintptr_t>(m_cur);
+        aligned = (cur + align - 1) & ~(uintptr_t(align) - 1);
+    }
+
+    m_cur = reinterpret_cast<std::byte *>(aligned + size);
+    m_size += size;
+    return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::add_block(size_t size) {
+    // not make_unique, which would zero the block
+    m_blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    m_cur = m_blocks.back().data.get();
+    m_end = m_cur + size;
+}
+
+void Arena::clear() {
+    for (auto iter = m_dtors.rbegin(); iter != m_dtors.rend(); ++iter) {
+        iter->fn(iter->ptr);
+    }
+    m_dtors.clear();
+    m_size = 0;
+    m_count = 0;
+
+    if (m_blocks.empty()) {
+        return;
+    }
+
+    m_blocks.resize(1);
+    m_cur = m_blocks.front().data.get();
+    m_end = m_cur + m_blocks.front().size;
+}
+
+void Arena::rewind(const Mark &mark) {
+    assert(mark.dtors <= m_dtors.size() && mark.blocks <= m_blocks.size());
+    for (auto i = m_dtors.size(); i-- > mark.dtors;) {
+        m_dtors[i].fn(m_dtors[i].ptr);
+    }
+    m_dtors.resize(mark.dtors);
+    m_size = mark.size;
+    m_count = mark.count;
+
+    m_blocks.resize(mark.blocks);
+    m_cur = mark.cur;
+    m_end = m_blocks.empty() ? nullptr : m_blocks.back().data.get() + m_blocks.back().size;
+}
@@ -0,0 +1,98 @@
+#ifndef KIRAZ_ARENA_H
+#define KIRAZ_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Arena: Bump allocator for objects that all die together, like the nodes of a syntax
+ *        tree. Allocation is a pointer increment in the common case. Nothing is freed
+ *        individually; clear(), rewind() or the destructor runs the pending destructors in
+ *        reverse order of construction and releases the memory in bulk.
+ */
+class Arena {
+public:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    Arena() = default;
+    ~Arena() { clear(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief make: Constructs a T in the arena. Its destructor is remembered only if it has a
+     *        non-trivial one.
+     */
+    template <typename T, typename... Args>
+    T *make(Args &&...args) {
+        auto retval = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        ++m_count;
+        if constexpr (! std::is_trivially_destructible_v<T>) {
+            m_dtors.push_back({retval, [](void *p) { static_cast<T *>(p)->~T(); }});
+        }
+        return retval;
+    }
+
+    void *allocate(size_t size, size_t align);
+
+    /**
+     * @brief clear: Destroys everything made in the arena. The first block is kept for reuse.
+     */
+    void clear();
+
+    /**
+     * @brief Mark: A point in the life of the arena that it can be rewound to.
+     */
+    struct Mark {
+        size_t blocks = 0;
+        std::byte *cur = nullptr;
+        size_t dtors = 0;
+        size_t size = 0;
+        size_t count = 0;
+    };
+
+    Mark mark() const { return {m_blocks.size(), m_cur, m_dtors.size(), m_size, m_count}; }
+
+    /**
+     * @brief rewind: Destroys everything made since the given mark, newest first, and hands its
+     *        memory out again. Rewinding to a default constructed mark empties the arena.
+     */
+    void rewind(const Mark &mark);
+
+    /**
+     * @brief get_size: Number of bytes handed out since the last clear().
+     */
+    size_t get_size() const { return m_size; }
+
+    /**
+     * @brief get_count: Number of objects made since the last clear().
+     */
+    size_t get_count() const { return m_count; }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    struct Dtor {
+        void *ptr;
+        void (*fn)(void *);
+    };
+
+    void add_block(size_t size);
+
+    std::vector<Block> m_blocks;
+    std::vector<Dtor> m_dtors;
+    std::byte *m_cur = nullptr;
+    std::byte *m_end = nullptr;
+    size_t m_size = 0;
+    size_t m_count = 0;
+};
+
+#endif // KIRAZ_ARENA_H
@@ -1,81 +1,131 @@
 
 #include "Compiler.h"
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
 
 #include <fmt/format.h>
 
 #include <resource/FILE_io_ki.h>
+#include "Prelude.h"
+#include "ast/KeyNodes.h"
 #include "ast/Literal.h"
-
-Node::Ptr SymbolTable::s_module_ki;
-Node::Ptr SymbolTable::s_module_io;
+#include "ast/testModule.h"
 
 SymbolTable::~SymbolTable() {}
 
-Compiler *Compiler::s_current;
-
-extern Token::Ptr curtoken;
+thread_local Compiler *Compiler::s_current;
 
 Compiler::Compiler() {
     assert(! s_current);
     s_current = this;
-    Node::reset_root();
 }
 
 Compiler::~Compiler() {
-    if (buffer) {
-        yy_delete_buffer(buffer);
-        buffer = nullptr;
-    }
-    reset_parser();
     s_current = nullptr;
 }
 
 int Compiler::compile_file(const std::string &file_name) {
-    yyin = fopen(file_name.data(), "rb");
-    if (! yyin) {
-        perror(file_name.data());
+    TimeReport::Timer timer(m_report, TimeReport::Phase::Total);
+    auto source = Source::map_file(file_name);
+    if (! source) {
+        set_error(FF("{}: {}\n", file_name, std::strerror(errno)));
         return 2;
     }
 
-    yyparse();
+    parse(std::move(source));
     auto root = Node::get_root();
-    reset();
+    reset_parser();
 
-    return compile(root);
+    auto retval = compile(root);
+    if (retval != 0) {
+        set_error(FF("{}: {}", file_name, get_error()));
+    }
+    return retval;
 }
 
-int Compiler::compile_string(const std::string &code) {
-    buffer = yy_scan_string(code.data());
-    yyparse();
+int Compiler::compile_string(std::string_view code) {
+    TimeReport::Timer timer(m_report, TimeReport::Phase::Total);
+    parse(Source::copy(code));
     auto root = Node::get_root();
-    reset();
+    reset_parser();
 
     return compile(root);
 }
 
-Node::Ptr Compiler::compile_module(const std::string &str) {
-    buffer = yy_scan_string(str.data());
-    yyparse();
+Node::Ptr Compiler::compile_module(std::string_view str) {
+    parse(Source::copy(str));
     auto retval = Node::pop_root();
-    reset();
-    assert(retval);
+    reset_parser();
     return retval;
 }
 
+const Node::Ptr &Compiler::get_module_io() {
+    if (! m_module_io) {
+        if (auto blob = prelude::io(); ! blob.empty()) {
+            m_module_io = prelude::load(m_parser, blob);
+        } else {
+            m_module_io = compile_module(FILE_io_ki);
+        }
+        assert(m_module_io);
+    }
+    return m_module_io;
+}
+
+Node::Ptr Compiler::get_module(Symbol name) {
+    // the modules that come with the compiler, by the name they are imported as
+    static const struct {
+        Symbol name;
+        const Node::Ptr &(Compiler::*load)();
+    } modules[] = {
+            {Symbol::intern("io"), &Compiler::get_module_io},
+    };
+
+    for (const auto &module : modules) {
+        if (module.name == name) {
+            return (this->*module.load)();
+        }
+    }
+    return nullptr;
+}
+
+void Compiler::parse(std::unique_ptr<Source> source) {
+    TimeReport::Timer timer(m_report, TimeReport::Phase::Parse);
+    auto nodes = m_parser.get_arena().get_count();
+
+    m_source = std::move(source);
+    if (m_parser.parse(*m_source) != 0) {
+        set_error(m_parser.get_error());
+    }
+
+    if (m_report) {
+        m_report->counts().nodes += m_parser.get_arena().get_count() - nodes;
+    }
+}
+
 void Compiler::reset_parser() {
-    curtoken.reset();
-    Node::reset_root();
-    Token::colno = 0;
-    yylex_destroy();
+    m_parser.reset();
+    m_source.reset();
 }
 
 void Compiler::reset() {
-    if (buffer) {
-        yy_delete_buffer(buffer);
-        buffer = nullptr;
+    if (m_prelude_end) {
+        m_parser.rewind(*m_prelude_end);
+    } else {
+        // the prelude may sit among the nodes of the first compilation, load it again on its own
+        m_parser.rewind({});
+        m_module_io = nullptr;
+        get_module_io();
+        m_prelude_end = m_parser.get_arena().mark();
     }
+
     reset_parser();
+    m_types.clear();
+    m_ctx = WasmContext();
+    m_wasm.clear();
+    m_error.clear();
 }
 
 int Compiler::compile(Node::Ptr root) {
@@ -83,31 +133,114 @@ int Compiler::compile(Node::Ptr root) {
         return 1;
     }
 
+    {
+        // the prelude is loaded once, by the first symbol table
+        TimeReport::Timer timer(m_report, TimeReport::Phase::Prelude);
+        get_module_io();
+    }
+
     SymbolTable st(ScopeType::Module);
 
-    if (auto ret = root->compute_stmt_type(st)) {
-        set_error(FF("Error at {}:{}: {}\n", ret->get_line(), ret->get_col(), ret->get_error()));
-        Node::reset_root();
-        return 1;
+    {
+        TimeReport::Timer timer(m_report, TimeReport::Phase::Check);
+        if (auto ret = root->compute_stmt_type(st)) {
+            set_error(FF("Error at {}:{}: {}\n", ret->get_line(), ret->get_col(),
+                    ret->get_error()));
+            Node::reset_root();
+            return 1;
+        }
+    }
+
+    if (m_report) {
+        m_report->counts().scopes += st.get_scope_count();
+        m_report->counts().symbols += st.get_symbol_count();
+    }
+
+    // a misspelt entry point would otherwise leave no function to keep
+    if (auto module = dyn_cast<ast::Module>(root)) {
+        auto missing = opt::missing_entry_points(*module, m_optimize);
+        if (! missing.empty()) {
+            set_error(FF("Entry point '{}' is not a function of the module\n", missing.front()));
+            Node::reset_root();
+            return 1;
+        }
+    }
+
+    if (m_optimize.level > 0) {
+        TimeReport::Timer timer(m_report, TimeReport::Phase::Optimize);
+        opt::optimize(root, m_parser, m_optimize);
     }
 
-    if (auto ret = root->gen_wat(m_ctx)) {
+    size_t bytes = 0;
+    try {
+        wasm::ModuleBuilder module;
+        module.set_share_locals(m_optimize.level > 0);
+        module.set_peephole(m_optimize.level > 0);
+        {
+            TimeReport::Timer timer(m_report, TimeReport::Phase::Codegen);
+            root->gen_wasm(module);
+        }
+
+        // both formats are written from the same module
+        TimeReport::Timer timer(m_report, TimeReport::Phase::Encode);
+        if (m_output == Output::Wasm) {
+            m_wasm = module.encode();
+            bytes = m_wasm.size();
+        } else {
+            fmt::memory_buffer text;
+            module.write_text(text);
+            m_ctx.body().append({text.data(), text.size()});
+            bytes = text.size();
+        }
+    } catch (const std::runtime_error &e) {
+        set_error(FF("{}\n", e.what()));
         return 2;
     }
 
+    if (m_report) {
+        m_report->counts().bytes += bytes;
+    }
     return 0;
 }
 
-SymbolTable::SymbolTable()
-        : m_symbols({
-                  std::make_shared<Scope>(Scope::SymTab{}, ScopeType::Module, nullptr),
-          }) {
-    if (! s_module_io) {
-        s_module_io = Compiler::current()->compile_module(FILE_io_ki);
-    }
+SymbolTable::SymbolTable() : m_symbols({new_scope(nullptr, ScopeType::Module, nullptr)}) {
+    Compiler::current()->get_module_io();
     add_builtin_keywords();
 }
 
+const Type *SymbolTable::get_type(Symbol name) const {
+    if (auto type = Type::get_builtin(name)) {
+        return type;
+    }
+
+    auto entry = get_symbol(name);
+    if (auto cls = dyn_cast<ast::ClassNode>(entry.stmt)) {
+        return Compiler::current()->get_types().get_class(name, cls);
+    }
+    return nullptr;
+}
+
+TypeTable &SymbolTable::get_types() {
+    return Compiler::current()->get_types();
+}
+
+Node::Ptr SymbolTable::get_module_io() {
+    return Compiler::current()->get_module_io();
+}
+
+Scope *SymbolTable::new_scope(const Scope *parent, ScopeType scope_type, Node::Ptr stmt) {
+    m_scopes.push_back(std::make_unique<Scope>(m_scopes.size(), parent, scope_type, stmt));
+    return m_scopes.back().get();
+}
+
+size_t SymbolTable::get_symbol_count() const {
+    size_t retval = 0;
+    for (const auto &scope : m_scopes) {
+        retval += scope->symbols.size();
+    }
+    return retval;
+}
+
 SymbolTable::SymbolTable(ScopeType scope_type) : SymbolTable() {
     m_symbols.back()->scope_type = scope_type;
 }
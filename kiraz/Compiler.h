@@ -1,11 +1,16 @@
 #pragma once
 #include <cassert>
-#include <map>
+#include <optional>
+#include <unordered_map>
 
 #include <kiraz/Node.h>
-
-#include <lexer.hpp>
-#include <unordered_set> 
+#include <kiraz/ParseContext.h>
+#include <kiraz/Rope.h>
+#include <kiraz/Source.h>
+#include <kiraz/SymbolMap.h>
+#include <kiraz/Type.h>
+#include <kiraz/opt/Optimize.h>
+#include <kiraz/wasm/Binary.h>
 
 enum class ScopeType {
     Module,
@@ -14,32 +19,38 @@ enum class ScopeType {
     Method,
 };
 
+/**
+ * @brief Scope: The symbols declared in one scope, linked to the enclosing one. Entering a scope
+ *        does not copy anything; lookups walk the chain outwards instead.
+ */
 struct Scope {
-    using SymTab = std::map<std::string, Node::Ptr>;
+    using SymTab = SymbolMap<Node::Ptr>;
 
-    Scope(const std::map<std::string, Node::Ptr> &map, ScopeType stype, Node::Ptr s)
-            : symbols(map), scope_type(stype), stmt(s) {}
+    Scope(uint32_t i, const Scope *p, ScopeType stype, Node::Ptr s)
+            : id(i), parent(p), scope_type(stype), stmt(s) {}
 
+    uint32_t id;
+    const Scope *parent;
     SymTab symbols;
     ScopeType scope_type;
     Node::Ptr stmt;
 
-    auto find(const std::string &s) { return symbols.find(s); }
-    auto find(const std::string &s) const { return symbols.find(s); }
-    auto end() { return symbols.end(); }
-    auto end() const { return symbols.end(); }
+    decltype(auto) operator[](Symbol s) { return (symbols[s]); }
 
-    decltype(auto) operator[](const std::string &s) { return (symbols[s]); }
-    Node::SymTabEntry get_symbol(const std::string &name) const {
-        auto iter = symbols.find(name);
-        if (iter == symbols.end()) {
-            return name;
+    /**
+     * @brief get_symbol: Looks the given name up in this scope and then in the enclosing ones.
+     */
+    Node::SymTabEntry get_symbol(Symbol name) const {
+        for (auto scope = this; scope; scope = scope->parent) {
+            if (auto iter = scope->symbols.find(name); iter != scope->symbols.end()) {
+                return {name, iter->second};
+            }
         }
-        return {name, iter->second};
+        return name;
     }
 
-      void add_symbol(const std::string &name, Node::Ptr m) {
-        assert(!name.empty());
+      void add_symbol(Symbol name, Node::Ptr m) {
+        assert(! name.empty());
         symbols[name] = m;
     }
 };
@@ -64,69 +75,97 @@ public:
 
     virtual ~SymbolTable();
 
-    bool is_builtin_keyword(const std::string& name) const {
-        static const std::unordered_set<std::string> builtins = {
-            "and", "or", "not"
-        };
-        return builtins.find(name) != builtins.end();
+    bool is_builtin_keyword(Symbol name) const {
+        return name == sym::And || name == sym::Or || name == sym::Not;
     }
 
     void add_builtin_keywords() {
-        m_symbols.back()->add_symbol("and", nullptr);
-        m_symbols.back()->add_symbol("or", nullptr);
-        m_symbols.back()->add_symbol("not", nullptr);
-
-        m_symbols.back()->add_symbol("Integer64", nullptr);
-        m_symbols.back()->add_symbol("String", nullptr);
-        m_symbols.back()->add_symbol("Void", nullptr);
-        m_symbols.back()->add_symbol("Class", nullptr);
-        m_symbols.back()->add_symbol("Module", nullptr);
-        m_symbols.back()->add_symbol("Integer64", nullptr);
-        m_symbols.back()->add_symbol("true", nullptr);
-        m_symbols.back()->add_symbol("false", nullptr);
+        m_symbols.back()->add_symbol(sym::And, nullptr);
+        m_symbols.back()->add_symbol(sym::Or, nullptr);
+        m_symbols.back()->add_symbol(sym::Not, nullptr);
+
+        m_symbols.back()->add_symbol(sym::Integer64, nullptr);
+        m_symbols.back()->add_symbol(sym::String, nullptr);
+        m_symbols.back()->add_symbol(sym::Void, nullptr);
+        m_symbols.back()->add_symbol(sym::Class, nullptr);
+        m_symbols.back()->add_symbol(sym::Module, nullptr);
+        m_symbols.back()->add_symbol(sym::True, nullptr);
+        m_symbols.back()->add_symbol(sym::False, nullptr);
 
     }
 
-    Node::Ptr add_symbol(const std::string &name, Node::Ptr m) {
+    Node::Ptr add_symbol(Symbol name, Node::Ptr m) {
         assert(! name.empty());
         (*m_symbols.back())[name] = m;
         return m;
     }
 
-    Node::SymTabEntry get_symbol(const std::string &name) const {
+    Node::SymTabEntry get_symbol(Symbol name) const {
         return m_symbols.back()->get_symbol(name);
     }
 
-    const auto &get_symbols() const { return m_symbols.back()->symbols; }
+    /**
+     * @brief get_type: The type the given name refers to, a builtin or a class visible from the
+     *        current scope. nullptr if there is none.
+     */
+    const Type *get_type(Symbol name) const;
+
+    TypeTable &get_types();
 
     ScopeRef enter_scope(ScopeType scope_type, Node::Ptr stmt) {
-        assert(stmt->get_cur_symtab() == m_symbols.back());
-        m_symbols.emplace_back(
-                std::make_shared<Scope>(m_symbols.back()->symbols, scope_type, stmt));
+        assert(stmt->get_scope_id() == m_symbols.back()->id);
+        m_symbols.push_back(new_scope(m_symbols.back(), scope_type, stmt));
         assert(m_symbols.size() > 1);
         return ScopeRef(*this);
     }
 
+    /**
+     * @brief get_scope: The scope with the given id. Scopes outlive exit_scope(), so the ids
+     *        recorded in nodes during type checking stay valid for code generation. Lookups
+     *        through a scope that was left also see symbols added to its parents afterwards.
+     */
+    const Scope &get_scope(uint32_t id) const {
+        assert(id < m_scopes.size());
+        return *m_scopes[id];
+    }
+
+    /**
+     * @brief get_scope_count, get_symbol_count: Size of the table, over all scopes ever entered.
+     */
+    size_t get_scope_count() const { return m_scopes.size(); }
+    size_t get_symbol_count() const;
+
     auto get_cur_symtab() { return m_symbols.back(); }
     auto get_cur_symtab() const { return m_symbols.back(); }
     auto get_scope_type() const { return m_symbols.back()->scope_type; }
     auto get_scope_stmt() const { return m_symbols.back()->stmt; }
 
-    static auto get_module_io() { return s_module_io; }
+    /**
+     * @brief get_func: The function whose body is being checked, nullptr outside of functions.
+     */
+    Node::Ptr get_func() const {
+        for (const Scope *scope = m_symbols.back(); scope; scope = scope->parent) {
+            if (scope->scope_type == ScopeType::Func || scope->scope_type == ScopeType::Method) {
+                return scope->stmt;
+            }
+        }
+        return nullptr;
+    }
+
+    static Node::Ptr get_module_io();
 
 private:
     void exit_scope() { m_symbols.pop_back(); }
+    Scope *new_scope(const Scope *parent, ScopeType scope_type, Node::Ptr stmt);
 
-    std::vector<std::shared_ptr<Scope>> m_symbols;
-
-    static Node::Ptr s_module_ki;
-    static Node::Ptr s_module_io;
+    std::vector<std::unique_ptr<Scope>> m_scopes;
+    std::vector<Scope *> m_symbols;
 };
 
 class WasmContext {
     struct Streams {
-        std::stringstream locals;
-        std::stringstream body;
+        Rope locals;
+        Rope body;
     };
 
 public:
@@ -168,11 +207,11 @@ public:
             auto iter = m_streams.rbegin();
             auto &source = *iter;
             auto &target = *std::next(iter);
-            target.body << source.locals.str();
-            target.body << source.body.str();
+            target.body.splice(source.locals);
+            target.body.splice(source.body);
         }
         m_streams.pop_back();
-        assert(m_streams.size() > 0 || m_streams.back().locals.str().empty());
+        assert(m_streams.size() > 0 || m_streams.back().locals.empty());
     }
 
 private:
@@ -182,18 +221,68 @@ private:
 
 class Compiler {
 public:
+    /**
+     * @brief current: The compiler running on the calling thread. Any number of compilers can
+     *        run in parallel as long as each has its own thread.
+     */
     static Compiler *current() { return s_current; }
     Compiler();
 
+    /**
+     * @brief Output: What compile() produces. Wat output goes to the wasm context, binary output
+     *        is encoded directly and is available from get_wasm().
+     */
+    enum class Output {
+        Wat,
+        Wasm,
+    };
+
+    void set_output(Output output) { m_output = output; }
+
+    /**
+     * @brief set_optimize: The optimizations to run between type checking and code generation.
+     */
+    void set_optimize(const opt::Options &options) { m_optimize = options; }
+
+    /**
+     * @brief set_report: Collects timing and size information about the following compilations
+     *        into the given report. Pass nullptr to stop.
+     */
+    void set_report(TimeReport *report) {
+        m_report = report;
+        m_parser.set_report(report);
+    }
+
+    /**
+     * @brief compile_file: Compiles the given file. Its diagnostics start with the file name.
+     */
     int compile_file(const std::string &file_name);
-    int compile_string(const std::string &str);
-    Node::Ptr compile_module(const std::string &str);
+    int compile_string(std::string_view str);
+    Node::Ptr compile_module(std::string_view str);
 
-    static void reset_parser();
+    /**
+     * @brief get_module_io: The io module, loaded from its precompiled blob on first use.
+     */
+    const Node::Ptr &get_module_io();
+
+    /**
+     * @brief get_module: The module that `import name;` brings in, one of those that come with
+     *        the compiler. nullptr if there is none of that name.
+     */
+    Node::Ptr get_module(Symbol name);
+
+    /**
+     * @brief reset: Gets the compiler ready for an unrelated compilation. Nodes, types, output
+     *        and errors of earlier compilations are released and their memory is reused; only
+     *        the prelude stays loaded, so a long running compiler does not pay for it again.
+     */
     void reset();
+
     void set_error(const std::string &str) { m_error = str; }
     const auto &get_error() const { return m_error; }
     const auto &get_wasm_ctx() const { return m_ctx; }
+    const auto &get_wasm() const { return m_wasm; }
+    auto &get_types() { return m_types; }
 
     ~Compiler();
 
@@ -201,8 +290,23 @@ protected:
     int compile(Node::Ptr root);
 
 private:
-    YY_BUFFER_STATE buffer = nullptr;
+    /**
+     * @brief parse: Runs the parser over the given source, scanning it in place. The source is
+     *        kept alive until reset_parser(), tokens point into it.
+     */
+    void parse(std::unique_ptr<Source> source);
+    void reset_parser();
+
+    ParseContext m_parser;
+    std::unique_ptr<Source> m_source;
+    Node::Ptr m_module_io = nullptr;
+    std::optional<Arena::Mark> m_prelude_end;
+    TypeTable m_types;
     std::string m_error;
     WasmContext m_ctx;
-    static Compiler *s_current;
+    Output m_output = Output::Wat;
+    opt::Options m_optimize;
+    std::vector<uint8_t> m_wasm;
+    TimeReport *m_report = nullptr;
+    static thread_local Compiler *s_current;
 };
@@ -1,18 +1,43 @@
 
 #include "Node.h"
 
+#include <stdexcept>
 #include <string>
 
 #include <kiraz/Compiler.h>
+#include <kiraz/ParseContext.h>
+#include <kiraz/ast/Dump.h>
 
-int64_t Node::s_next_id;
-std::vector<Node::Ptr> Node::s_roots;
-Token::Ptr curtoken;
+Node::Node(NodeKind kind, int id)
+        : m_id(id), m_kind(kind), n_id(ParseContext::current()->next_id()) {}
 
-Node::Node() : n_id(FF("Ki{}", ++s_next_id)) {}
+Node::Node() : Node(NodeKind::Unknown, 0) {}
 
 Node::~Node() {}
 
+std::string Node::as_string() const {
+    fmt::memory_buffer out;
+    ast::dump(*this, out);
+    return fmt::to_string(out);
+}
+
+void Node::dump(ast::Dumper &out) const {
+    out << "Node";
+}
+
+const std::string &Node::get_error() const {
+    return ParseContext::current()->get_node_error(this);
+}
+
+Node::Ptr Node::set_error(const std::string &error) {
+    ParseContext::current()->set_node_error(this, error);
+    return error.empty() ? nullptr : this;
+}
+
+void Node::set_cur_symtab(const Scope *symtab) {
+    m_scope = symtab->id;
+}
+
 Node::Ptr Node::compute_stmt_type(SymbolTable &st) {
     set_cur_symtab(st.get_cur_symtab());
     return nullptr;
@@ -26,24 +51,26 @@ Node::Ptr Node::add_to_symtab_ordered(SymbolTable &st) {
     return nullptr;
 }
 
+Node::Ptr &Node::current_root() {
+    return ParseContext::current()->current_root();
+}
+
+const Node::Ptr &Node::get_root() {
+    return ParseContext::current()->get_root();
+}
+
 Node::Ptr Node::pop_root() {
-    assert(! s_roots.empty());
-    auto retval = s_roots.back();
-    s_roots.pop_back();
-    return retval;
+    return ParseContext::current()->pop_root();
 }
 
 const Node::Ptr &Node::get_root_before() {
-    assert(s_roots.size() > 1);
-    return *std::next(s_roots.rbegin());
+    return ParseContext::current()->get_root_before();
 }
 
-Node::Ptr Node::gen_wat(WasmContext &) {
-    //assert(! n_id.empty());
-    return nullptr;
+void Node::reset_root() {
+    ParseContext::current()->reset_root();
 }
 
-Node::Ptr Node::gen_wat(WasmContext &, const std::string &id) const {
-    //assert(! id.empty());
-    return nullptr;
+const Type *Node::gen_wasm(wasm::ModuleBuilder &) const {
+    throw std::runtime_error(FF("{} is not supported in code generation", as_string()));
 }
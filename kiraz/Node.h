@@ -1,8 +1,14 @@
 #ifndef KIRAZ_NODE_H
 #define KIRAZ_NODE_H
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include <fmt/ranges.h>
@@ -11,23 +17,124 @@
 
 #include <kiraz/Token.h>
 
-extern int yylineno;
-
 class SymbolTable;
 struct Scope;
-class WasmContext;
-class Node : public std::enable_shared_from_this<Node> {
+class Type;
+
+namespace ast {
+class Dumper;
+}
+
+namespace wasm {
+class ModuleBuilder;
+} // namespace wasm
+
+/**
+ * @brief SourceLoc: Line and column packed into 32 bits. Lines past 2^20 or columns past 2^12
+ *        saturate at the largest value that fits.
+ */
+class SourceLoc {
+public:
+    static constexpr int ColBits = 12;
+    static constexpr uint32_t MaxCol = (1u << ColBits) - 1;
+    static constexpr uint32_t MaxLine = (1u << (32 - ColBits)) - 1;
+
+    SourceLoc() = default;
+    SourceLoc(int line, int col)
+            : m_value((std::min<uint32_t>(std::max(line, 0), MaxLine) << ColBits)
+                      | std::min<uint32_t>(std::max(col, 0), MaxCol)) {}
+
+    int get_line() const { return m_value >> ColBits; }
+    int get_col() const { return m_value & MaxCol; }
+
+private:
+    uint32_t m_value = 0;
+};
+
+/*
+ * Concrete node classes, all in namespace ast. Classes that have subclasses of their own are
+ * followed by them, so that the family can be tested for as a range: see OpBinary.
+ */
+#define KIRAZ_NODE_KINDS(X)                                                                        \
+    X(Identifier)                                                                                  \
+    X(Integer)                                                                                     \
+    X(SignedNode)                                                                                  \
+    X(StringLiteral)                                                                               \
+    X(ArgNode)                                                                                     \
+    X(FuncArgs)                                                                                    \
+    X(NodeList)                                                                                    \
+    X(FuncNode)                                                                                    \
+    X(IfNode)                                                                                      \
+    X(WhileNode)                                                                                   \
+    X(ImportNode)                                                                                  \
+    X(CallNode)                                                                                    \
+    X(ClassNode)                                                                                   \
+    X(Combined)                                                                                    \
+    X(ReturnNode)                                                                                  \
+    X(DotNode)                                                                                     \
+    X(LetNode)                                                                                     \
+    X(AssignNode)                                                                                  \
+    X(Module)                                                                                      \
+    X(OpAdd)                                                                                       \
+    X(OpSub)                                                                                       \
+    X(OpMult)                                                                                      \
+    X(OpDivF)                                                                                      \
+    X(OpEq)                                                                                        \
+    X(OpGt)                                                                                        \
+    X(OpGe)                                                                                        \
+    X(OpLt)                                                                                        \
+    X(OpLe)
+
+enum class NodeKind : uint8_t {
+    Unknown,
+#define X(name) name,
+    KIRAZ_NODE_KINDS(X)
+#undef X
+    FirstOpBinary = OpAdd,
+    LastOpBinary = OpLe,
+};
+
+/**
+ * @brief Node: Base of all syntax tree nodes. Nodes are allocated in the arena of the ParseContext
+ *        that parsed them and are freed together with it, so links between nodes are plain
+ *        pointers.
+ */
+class Node {
 public:
-    using Ptr = std::shared_ptr<Node>;
-    using Cptr = std::shared_ptr<const Node>;
+    using Ptr = Node *;
+    using Cptr = const Node *;
 
-    Node(int id) : m_id(id) {}
+    Node(NodeKind kind, int id);
     Node();
     virtual ~Node();
 
-    virtual std::string as_string() const = 0;
+    /**
+     * @brief get_kind: The concrete class of this node, see isa(), cast() and dyn_cast().
+     */
+    auto get_kind() const { return m_kind; }
+
+    /**
+     * @brief as_string: Textual form of the tree rooted at this node, see ast::dump().
+     */
+    std::string as_string() const;
     void print() { fmt::print("{}\n", as_string()); }
 
+    /**
+     * @brief dump: Describes this node to the dumper, queueing children instead of formatting
+     *        them. Every node class hides this with its own layout; ast::dump() calls the right
+     *        one by kind.
+     */
+    void dump(ast::Dumper &out) const;
+
+    /**
+     * @brief for_each_child: Calls fn with a reference to each child that is evaluated, in order
+     *        of evaluation, so that passes can replace it. Names and type annotations are not
+     *        children in this sense. Node classes with children hide this like they do dump();
+     *        ast::for_each_child() calls the right one by kind.
+     */
+    template <typename Fn>
+    void for_each_child(Fn &&) {}
+
     auto get_id() const { return m_id; }
     
     Node* get_parent() const {
@@ -37,28 +144,9 @@ public:
         m_parent = parent;
     }
 
-    void set_pos(int l, int c) {
-        m_line = l;
-        m_col = c;
-    }
-
-    template <typename T, typename... Args>
-    static auto add(Args &&...args) {
-        auto root = std::make_shared<T>(std::forward<Args>(args)...);
-        root->set_pos(yylineno, Token::colno);
-        s_roots.back() = root;
-        return root;
-    }
+    void set_pos(int l, int c) { m_loc = SourceLoc(l, c); }
 
-    template <typename T>
-    static auto wrap(Node::Ptr node) {
-        return std::make_shared<T>(std::vector{node});
-    }
-
-    static auto &current_root() {
-        //assert(! s_roots.empty());
-        return s_roots.back();
-    }
+    static Ptr &current_root();
 
     virtual bool is_func() const { return false; }
     virtual bool is_class() const { return false; }
@@ -74,21 +162,21 @@ public:
     virtual Node::Cptr get_parent_new() const { return nullptr; }
 
     struct SymTabEntry {
-        std::string name;
-        Cptr stmt;
+        Symbol name;
+        Cptr stmt = nullptr;
 
         SymTabEntry() {}
         SymTabEntry(const Ptr s) : stmt(s) {}
         SymTabEntry(const Cptr s) : stmt(s) {}
-        SymTabEntry(const std::string &n, const Cptr s = nullptr) : name(n), stmt(s) {}
+        SymTabEntry(Symbol n, const Cptr s = nullptr) : name(n), stmt(s) {}
 
         operator bool() const { return stmt != nullptr; }
         operator Cptr() const { return stmt; }
-        bool first_letter_uppercase() { return name.front() >= 'A' && name.front() <= 'Z'; }
-        bool first_letter_lowercase() { return name.front() >= 'a' && name.front() <= 'z'; }
+        bool first_letter_uppercase() { return std::isupper(name.str().front()); }
+        bool first_letter_lowercase() { return std::islower(name.str().front()); }
         bool is_builtin() {
-            return name == "and" || name == "or" || name == "not" || name == "Boolean"
-                    || name == "String" || name == "Integer64";
+            return name == sym::And || name == sym::Or || name == sym::Not
+                    || name == sym::Boolean || name == sym::String || name == sym::Integer64;
         }
     };
     /**
@@ -143,78 +231,116 @@ public:
     virtual const SymbolTable *get_subsymbol_all() const { return {}; }
 
     /*
-     * Static interface
+     * Static interface, operates on the current ParseContext of the calling thread
      */
-    static const Ptr &get_root() { return s_roots.back(); }
+    static const Ptr &get_root();
     static Ptr pop_root();
     static const Ptr &get_root_before();
     static const Ptr &get_first();
     static const Ptr &get_first_before();
-    static void reset_root() {
-        s_roots.emplace_back();
-        s_next_id = 0;
-    }
-    auto get_line() const { return m_line; }
-    auto get_col() const { return m_col; }
-    const auto &get_error() const { return m_error; }
+    static void reset_root();
+    auto get_line() const { return m_loc.get_line(); }
+    auto get_col() const { return m_loc.get_col(); }
 
-    Node::Ptr set_error(const std::string &error) {
-        m_error = error;
-        return m_error.empty() ? nullptr : shared_from_this();
-    }
+    /**
+     * @brief get_error, set_error: Errors are rare, so they are not stored in the node but in the
+     *        diagnostics table of the current ParseContext.
+     * @return set_error returns this node unless the error is empty.
+     */
+    const std::string &get_error() const;
+    Node::Ptr set_error(const std::string &error);
 
-    virtual std::string get_type() const {
-        return ""; 
+    /**
+     * @brief get_type: Name of the declared type of this statement, if it has one.
+     */
+    virtual Symbol get_type() const {
+        return {};
     }
 
     virtual std::vector<Node::Ptr> get_args() const { 
         return {};  
     }
 
-    const auto &get_stmt_type() const { return m_type; }
+    /**
+     * @brief get_stmt_type, set_stmt_type: Type of the value of this statement, or nullptr if it
+     *        has none or it is not known. Types are canonical, compare them by pointer.
+     */
+    const Type *get_stmt_type() const { return m_type; }
 
-    void set_stmt_type(const Cptr &type) {
+    void set_stmt_type(const Type *type) {
         assert(type);
         m_type = type;
     }
 
-    void set_cur_symtab(std::shared_ptr<Scope> symtab) {
-        //assert((! m_cur_symtab) || (m_cur_symtab == symtab));
-        m_cur_symtab = symtab;
-    }
-    auto get_cur_symtab() { return m_cur_symtab; }
-    auto get_cur_symtab() const { return m_cur_symtab; }
+    /**
+     * @brief set_cur_symtab: Records the scope this node was checked in. Only the id of the scope
+     *        is kept, see SymbolTable::get_scope().
+     */
+    void set_cur_symtab(const Scope *symtab);
+    auto get_scope_id() const { return m_scope; }
 
-    virtual Node::Ptr gen_wat(WasmContext &);
-    virtual Node::Ptr gen_wat(WasmContext &, const std::string &id) const;
+    /**
+     * @brief gen_wasm: Emits the code of this statement, into the current function of the given
+     *        module for code inside functions. The module is then encoded in the binary format or
+     *        written in the text format.
+     * @return The type of the value left on the stack, nullptr if there is none.
+     * @throw std::runtime_error for statements code generation does not support yet.
+     */
+    virtual const Type *gen_wasm(wasm::ModuleBuilder &) const;
 
-    const auto &get_id_new() const {
-        //assert(! n_id.empty());
-        return n_id;
-    }
+    /**
+     * @brief get_id_new: Name of this node in generated code. Nodes only store a serial number;
+     *        the name is formatted on request.
+     */
+    std::string get_id_new() const { return FF("Ki{}", n_id); }
 
-    void set_id(const std::string &v) {
-        //assert(! v.empty());
-        n_id = v;
-    }
+    auto get_serial() const { return n_id; }
 
-protected:
-    std::shared_ptr<Scope> m_cur_symtab;
+    static constexpr uint32_t NoScope = UINT32_MAX;
 
 private:
-    static std::vector<Node::Ptr> s_roots;
-
-    Cptr m_type;
-    int m_id;
-
-    static int64_t s_next_id;
-    std::string n_id;
-    std::string m_error;
-    int m_line = 0;
-    int m_col = 0;
-    Node* m_parent;
+    const Type *m_type = nullptr;
+    Node* m_parent = nullptr;
+
+    int16_t m_id;
+    NodeKind m_kind;
+    uint32_t n_id;
+    SourceLoc m_loc;
+    uint32_t m_scope = NoScope;
 };
 
+/**
+ * @brief isa, cast, dyn_cast: Checked downcasts that compare the kind tag instead of going through
+ *        RTTI. The target class tells which kinds it covers with a static classof(). Unlike
+ *        cast(), isa() and dyn_cast() accept null and treat it as a mismatch.
+ */
+template <typename T>
+bool isa(const Node *node) {
+    return node && std::remove_cv_t<T>::classof(node);
+}
+
+template <typename T>
+T *cast(Node *node) {
+    assert(isa<T>(node));
+    return static_cast<T *>(node);
+}
+
+template <typename T>
+const T *cast(const Node *node) {
+    assert(isa<T>(node));
+    return static_cast<const T *>(node);
+}
+
+template <typename T>
+T *dyn_cast(Node *node) {
+    return isa<T>(node) ? static_cast<T *>(node) : nullptr;
+}
+
+template <typename T>
+const T *dyn_cast(const Node *node) {
+    return isa<T>(node) ? static_cast<const T *>(node) : nullptr;
+}
+
 template <>
 struct fmt::formatter<Node> : fmt::formatter<std::string> {
     format_context::iterator format(const Node &stmt, format_context &ctx) const {
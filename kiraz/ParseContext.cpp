@@ -0,0 +1,109 @@
+
+#include "ParseContext.h"
+
+#include <cassert>
+
+#include <lexer.hpp>
+
+thread_local ParseContext *ParseContext::s_current;
+
+ParseContext::ParseContext() : m_roots(1), m_previous(s_current) {
+    yylex_init_extra(this, &m_scanner);
+    s_current = this;
+}
+
+ParseContext::~ParseContext() {
+    assert(s_current == this);
+    s_current = m_previous;
+    yylex_destroy(m_scanner);
+}
+
+int ParseContext::parse(Source &source) {
+    auto buffer = yy_scan_buffer(source.buffer(), source.buffer_size(), m_scanner);
+    assert(buffer);
+    auto retval = yyparse(m_scanner, *this);
+    yy_delete_buffer(buffer, m_scanner);
+    return retval;
+}
+
+int ParseContext::parse(std::string_view text) {
+    auto source = Source::copy(text);
+    return parse(*source);
+}
+
+int ParseContext::lex(Node **lval, void *scanner) {
+    auto report = yyget_extra(scanner)->m_report;
+    if (! report) {
+        return yylex(lval, scanner);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto retval = yylex(lval, scanner);
+    report->add_scan(std::chrono::steady_clock::now() - start);
+    return retval;
+}
+
+void ParseContext::reset() {
+    m_token = {};
+    m_error.clear();
+    colno = 0;
+    yyset_lineno(1, m_scanner);
+    reset_root();
+}
+
+void ParseContext::rewind(const Arena::Mark &mark) {
+    m_roots.assign(1, nullptr);
+    m_next_id = 0;
+    m_node_errors.clear();
+    m_arena.rewind(mark);
+}
+
+int ParseContext::emit(int id, std::string_view text, int line) {
+    colno += text.size();
+    m_token = Token(id, text, line, colno);
+    return id;
+}
+
+int ParseContext::emit_identifier(std::string_view text, int line) {
+    colno += text.size();
+    m_token = Token(IDENTIFIER, text, line, colno, Symbol::intern(text));
+    return IDENTIFIER;
+}
+
+void ParseContext::skip(std::string_view text) {
+    if (auto nl = text.rfind('\n'); nl != text.npos) {
+        colno = text.size() - nl - 1;
+        return;
+    }
+    colno += text.size();
+}
+
+const std::string &ParseContext::get_node_error(const Node *node) const {
+    static const std::string empty;
+    auto iter = m_node_errors.find(node);
+    return iter == m_node_errors.end() ? empty : iter->second;
+}
+
+void ParseContext::set_node_error(const Node *node, const std::string &error) {
+    if (error.empty()) {
+        m_node_errors.erase(node);
+        return;
+    }
+    m_node_errors[node] = error;
+}
+
+int ParseContext::get_line() const {
+    return yyget_lineno(m_scanner);
+}
+
+const Node::Ptr &ParseContext::get_root_before() const {
+    assert(m_roots.size() > 1);
+    return *std::next(m_roots.rbegin());
+}
+
+Node::Ptr ParseContext::pop_root() {
+    assert(! m_roots.empty());
+    auto retval = m_roots.back();
+    m_roots.pop_back();
+    return retval;
+}
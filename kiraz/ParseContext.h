@@ -0,0 +1,138 @@
+#ifndef KIRAZ_PARSECONTEXT_H
+#define KIRAZ_PARSECONTEXT_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <kiraz/Arena.h>
+#include <kiraz/Node.h>
+#include <kiraz/Source.h>
+#include <kiraz/TimeReport.h>
+#include <kiraz/Token.h>
+
+/**
+ * @brief ParseContext: Everything the lexer and the parser used to keep in globals: the flex
+ *        scanner, the last token, the column counter and the stack of parse roots. Each
+ *        compilation owns one, so compilations on different threads do not share any state.
+ *
+ *        Nodes made through add() live in the context's arena and stay valid until the context
+ *        is destroyed or rewound past them; reset() does not free them.
+ *
+ *        The most recently constructed context on a thread is its current one; the static part
+ *        of the Node interface (get_root() etc.) operates on it.
+ */
+class ParseContext {
+public:
+    ParseContext();
+    ~ParseContext();
+
+    ParseContext(const ParseContext &) = delete;
+    ParseContext &operator=(const ParseContext &) = delete;
+
+    static ParseContext *current() { return s_current; }
+
+    /**
+     * @brief parse: Scans the given source in place and runs the parser over it.
+     * @return The return value of yyparse.
+     */
+    int parse(Source &source);
+
+    /**
+     * @brief parse: Parses a copy of the given text.
+     */
+    int parse(std::string_view text);
+
+    /**
+     * @brief reset: Forgets the last token and any syntax errors, rewinds line and column
+     *        counters and pushes a fresh root.
+     */
+    void reset();
+
+    /**
+     * @brief get_error: Syntax errors reported since the last reset(), one per line. They are
+     *        collected rather than printed so that the caller decides where they go.
+     */
+    const std::string &get_error() const { return m_error; }
+    void add_error(std::string_view str) { m_error.append(str); }
+
+    /**
+     * @brief get_node_error, set_node_error: Diagnostics table for the nodes in this context.
+     *        Setting an empty error removes the entry.
+     */
+    const std::string &get_node_error(const Node *node) const;
+    void set_node_error(const Node *node, const std::string &error);
+
+    /**
+     * @brief set_report: Times scanning and counts tokens into the given report, if any.
+     */
+    void set_report(TimeReport *report) { m_report = report; }
+
+    /**
+     * @brief lex: The scanner as the parser calls it; accounts for the call when a report is set.
+     */
+    static int lex(Node **lval, void *scanner);
+
+    /*
+     * Lexer interface
+     */
+    int emit(int id, std::string_view text, int line);
+    int emit_identifier(std::string_view text, int line);
+    void skip(std::string_view text);
+    const Token &get_token() const { return m_token; }
+    int get_line() const;
+    int colno = 0;
+
+    /*
+     * Parser interface
+     */
+    /**
+     * @brief make: Allocates a node in the arena without touching the parse roots.
+     */
+    template <typename T, typename... Args>
+    T *make(Args &&...args) {
+        return m_arena.make<T>(std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename... Args>
+    auto add(Args &&...args) {
+        auto root = make<T>(std::forward<Args>(args)...);
+        root->set_pos(get_line(), colno);
+        m_roots.back() = root;
+        return root;
+    }
+
+    Node::Ptr &current_root() { return m_roots.back(); }
+    const Node::Ptr &get_root() const { return m_roots.back(); }
+    const Node::Ptr &get_root_before() const;
+    Node::Ptr pop_root();
+    void reset_root() {
+        m_roots.emplace_back();
+        m_next_id = 0;
+    }
+
+    auto next_id() { return ++m_next_id; }
+    const Arena &get_arena() const { return m_arena; }
+
+    /**
+     * @brief rewind: Destroys the nodes made since the given mark of the arena and drops the parse
+     *        roots and every node diagnostic along with them.
+     */
+    void rewind(const Arena::Mark &mark);
+
+private:
+    void *m_scanner = nullptr;
+    TimeReport *m_report = nullptr;
+    Arena m_arena;
+    Token m_token;
+    std::string m_error;
+    std::unordered_map<const Node *, std::string> m_node_errors;
+    std::vector<Node::Ptr> m_roots;
+    uint32_t m_next_id = 0;
+
+    ParseContext *m_previous;
+    static thread_local ParseContext *s_current;
+};
+
+#endif // KIRAZ_PARSECONTEXT_H
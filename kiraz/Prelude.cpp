@@ -0,0 +1,295 @@
+
+#include "Prelude.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <kiraz/ParseContext.h>
+#include <kiraz/ast/FuncNode.h>
+#include <kiraz/ast/KeyNodes.h>
+#include <kiraz/ast/Literal.h>
+#include <kiraz/ast/testModule.h>
+
+namespace prelude {
+namespace {
+
+constexpr std::string_view Magic = "KIPR";
+constexpr uint32_t Version = 1;
+constexpr uint32_t NoNode = UINT32_MAX;
+
+enum class Kind : uint8_t {
+    Identifier,
+    ArgNode,
+    FuncArgs,
+    NodeList,
+    FuncNode,
+    ClassNode,
+    Module,
+};
+
+void put_u32(std::string &out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(char(v >> (8 * i)));
+    }
+}
+
+class Writer {
+public:
+    uint32_t add(const Node *node) {
+        if (! node) {
+            return NoNode;
+        }
+
+        switch (node->get_kind()) {
+        case NodeKind::Identifier: {
+            auto name = symbol(cast<ast::Identifier>(node)->get_name());
+            return begin(Kind::Identifier, node, {name});
+        }
+
+        case NodeKind::ArgNode: {
+            auto arg = cast<ast::ArgNode>(node);
+            auto name = add(arg->get_name());
+            auto type = add(arg->get_type_name());
+            return begin(Kind::ArgNode, node, {name, type});
+        }
+
+        case NodeKind::FuncArgs:
+            return begin(Kind::FuncArgs, node, add_list(cast<ast::FuncArgs>(node)->get_list()));
+
+        case NodeKind::NodeList:
+            return begin(Kind::NodeList, node, add_list(cast<ast::NodeList>(node)->get_list()));
+
+        case NodeKind::FuncNode: {
+            auto func = cast<ast::FuncNode>(node);
+            auto name = add(func->get_name());
+            auto args = add(func->get_arg_list());
+            auto ret = add(func->get_return_type());
+            auto body = add(func->get_body());
+            return begin(Kind::FuncNode, node, {name, args, ret, body});
+        }
+
+        case NodeKind::ClassNode: {
+            auto cls = cast<ast::ClassNode>(node);
+            auto name = add(cls->get_name());
+            auto stmts = add(cls->get_stmt_list());
+            auto parent = add(cls->get_parent_class());
+            return begin(Kind::ClassNode, node, {name, stmts, parent});
+        }
+
+        case NodeKind::Module: {
+            auto body = add(cast<ast::Module>(node)->get_body());
+            return begin(Kind::Module, node, {body});
+        }
+
+        default:
+            break;
+        }
+
+        throw std::runtime_error(FF("{} can not be part of a prelude", node->as_string()));
+    }
+
+    std::string finish(uint32_t root) const {
+        std::string retval(Magic);
+        put_u32(retval, Version);
+
+        put_u32(retval, m_symbols.size());
+        for (auto sym : m_symbols) {
+            put_u32(retval, sym.str().size());
+            retval.append(sym.str());
+        }
+
+        put_u32(retval, m_count);
+        retval.append(m_nodes);
+        put_u32(retval, root);
+        return retval;
+    }
+
+private:
+    uint32_t symbol(Symbol sym) {
+        auto [iter, added] = m_symbol_ids.try_emplace(sym, m_symbols.size());
+        if (added) {
+            m_symbols.push_back(sym);
+        }
+        return iter->second;
+    }
+
+    std::vector<uint32_t> add_list(const std::vector<Node::Ptr> &nodes) {
+        std::vector<uint32_t> retval{uint32_t(nodes.size())};
+        for (const auto &node : nodes) {
+            retval.push_back(add(node));
+        }
+        return retval;
+    }
+
+    uint32_t begin(Kind kind, const Node *node, const std::vector<uint32_t> &fields) {
+        m_nodes.push_back(char(kind));
+        put_u32(m_nodes, node->get_line());
+        put_u32(m_nodes, node->get_col());
+        for (auto field : fields) {
+            put_u32(m_nodes, field);
+        }
+        return m_count++;
+    }
+
+    std::unordered_map<Symbol, uint32_t> m_symbol_ids;
+    std::vector<Symbol> m_symbols;
+    std::string m_nodes;
+    uint32_t m_count = 0;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view blob) : m_blob(blob) {}
+
+    uint8_t u8() { return uint8_t(bytes(1)[0]); }
+
+    uint32_t u32() {
+        auto b = bytes(4);
+        uint32_t retval = 0;
+        for (int i = 0; i < 4; ++i) {
+            retval |= uint32_t(uint8_t(b[i])) << (8 * i);
+        }
+        return retval;
+    }
+
+    std::string_view bytes(size_t size) {
+        if (m_blob.size() - m_pos < size) {
+            throw std::runtime_error("Truncated prelude");
+        }
+        auto retval = m_blob.substr(m_pos, size);
+        m_pos += size;
+        return retval;
+    }
+
+    /**
+     * @brief count: Reads the number of items that follow, each taking at least item_size
+     *        bytes. The blob has to be large enough to hold them, so that a corrupt count does not
+     *        size a vector before the truncation is found.
+     */
+    uint32_t count(size_t item_size) {
+        auto retval = u32();
+        if ((m_blob.size() - m_pos) / item_size < retval) {
+            throw std::runtime_error("Truncated prelude");
+        }
+        return retval;
+    }
+
+    bool done() const { return m_pos == m_blob.size(); }
+
+private:
+    std::string_view m_blob;
+    size_t m_pos = 0;
+};
+
+} // namespace
+
+std::string serialize(const Node *module) {
+    Writer writer;
+    auto root = writer.add(module);
+    return writer.finish(root);
+}
+
+Node::Ptr load(ParseContext &ctx, std::string_view blob) {
+    Reader reader(blob);
+    if (reader.bytes(Magic.size()) != Magic || reader.u32() != Version) {
+        throw std::runtime_error("Not a prelude of this compiler version");
+    }
+
+    // a symbol is at least its length, a node its kind, line and column
+    std::vector<Symbol> symbols(reader.count(4));
+    for (auto &sym : symbols) {
+        sym = Symbol::intern(reader.bytes(reader.u32()));
+    }
+
+    std::vector<Node::Ptr> nodes(reader.count(9));
+    size_t count = 0;
+    auto node = [&] {
+        auto idx = reader.u32();
+        if (idx == NoNode) {
+            return Node::Ptr{};
+        }
+        if (idx >= count) {
+            throw std::runtime_error("Malformed prelude");
+        }
+        return nodes[idx];
+    };
+    auto symbol = [&] {
+        auto idx = reader.u32();
+        if (idx >= symbols.size()) {
+            throw std::runtime_error("Malformed prelude");
+        }
+        return symbols[idx];
+    };
+
+    for (; count < nodes.size(); ++count) {
+        auto kind = Kind(reader.u8());
+        auto line = reader.u32();
+        auto col = reader.u32();
+
+        Node::Ptr retval;
+        switch (kind) {
+        case Kind::Identifier:
+            retval = ctx.make<ast::Identifier>(symbol());
+            break;
+
+        case Kind::ArgNode: {
+            auto name = node();
+            retval = ctx.make<ast::ArgNode>(name, node());
+            break;
+        }
+
+        case Kind::FuncArgs: {
+            auto args = ctx.make<ast::FuncArgs>();
+            for (auto n = reader.u32(); n > 0; --n) {
+                args->add_argument(node());
+            }
+            retval = args;
+            break;
+        }
+
+        case Kind::NodeList: {
+            auto stmts = ctx.make<ast::NodeList>();
+            for (auto n = reader.u32(); n > 0; --n) {
+                stmts->add_node(node());
+            }
+            retval = stmts;
+            break;
+        }
+
+        case Kind::FuncNode: {
+            auto name = node();
+            auto args = node();
+            auto ret = node();
+            retval = ctx.make<ast::FuncNode>(name, args, ret, node());
+            break;
+        }
+
+        case Kind::ClassNode: {
+            auto name = node();
+            auto stmts = node();
+            retval = ctx.make<ast::ClassNode>(name, stmts, node());
+            break;
+        }
+
+        case Kind::Module:
+            retval = ctx.make<ast::Module>(node());
+            break;
+
+        default:
+            throw std::runtime_error("Malformed prelude");
+        }
+
+        retval->set_pos(line, col);
+        nodes[count] = retval;
+    }
+
+    auto root = node();
+    if (! root || ! reader.done()) {
+        throw std::runtime_error("Malformed prelude");
+    }
+    return root;
+}
+
+} // namespace prelude
@@ -0,0 +1,42 @@
+#ifndef KIRAZ_PRELUDE_H
+#define KIRAZ_PRELUDE_H
+
+#include <string>
+#include <string_view>
+
+#include <kiraz/Node.h>
+
+class ParseContext;
+
+/**
+ * Preludes like io.ki are parsed and checked at build time and embedded as a binary blob, so a
+ * compiler only has to rebuild their nodes instead of lexing and parsing them again.
+ *
+ * A blob holds the symbol names used by the module followed by its nodes, children before their
+ * parents, each referring to its children by index. Only the declarations a prelude can contain
+ * are supported: modules, statement lists, functions and their arguments, classes and
+ * identifiers.
+ */
+namespace prelude {
+
+/**
+ * @brief serialize: Encodes the given module.
+ * @throw std::runtime_error if the module contains a node a prelude can not have.
+ */
+std::string serialize(const Node *module);
+
+/**
+ * @brief load: Rebuilds a serialized module in the arena of the given context.
+ * @throw std::runtime_error if the blob is malformed.
+ */
+Node::Ptr load(ParseContext &ctx, std::string_view blob);
+
+/**
+ * @brief io: The blob for io.ki. It is empty in the tool that generates it, in which case the
+ *        compiler falls back to compiling the text.
+ */
+std::string_view io();
+
+} // namespace prelude
+
+#endif // KIRAZ_PRELUDE_H
@@ -0,0 +1,43 @@
+
+#include "Rope.h"
+
+#include <algorithm>
+
+void Rope::append(std::string_view s) {
+    if (s.empty()) {
+        return;
+    }
+
+    if (m_chunks.empty() || m_chunks.back().capacity() - m_chunks.back().size() < s.size()) {
+        m_chunks.emplace_back().reserve(std::max(ChunkSize, s.size()));
+    }
+
+    m_chunks.back().append(s);
+    m_size += s.size();
+}
+
+void Rope::splice(Rope &other) {
+    m_chunks.splice(m_chunks.end(), other.m_chunks);
+    m_size += other.m_size;
+    other.m_size = 0;
+}
+
+void Rope::clear() {
+    m_chunks.clear();
+    m_size = 0;
+}
+
+std::string Rope::str() const {
+    std::string retval;
+    retval.reserve(m_size);
+    for (const auto &chunk : m_chunks) {
+        retval += chunk;
+    }
+    return retval;
+}
+
+void Rope::write(std::ostream &out) const {
+    for (const auto &chunk : m_chunks) {
+        out.write(chunk.data(), chunk.size());
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef KIRAZ_ROPE_H
+#define KIRAZ_ROPE_H
+
+#include <cstddef>
+#include <list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+/**
+ * @brief Rope: Text built from a list of chunks. Appending fills the last chunk until it runs out
+ *        of room, and splice() moves the chunks of another rope over without touching their
+ *        contents, so nested output can be assembled at a cost that does not depend on how deep
+ *        it is. The text is only put together once, by str() or write().
+ */
+class Rope {
+public:
+    static constexpr size_t ChunkSize = 4 * 1024;
+
+    Rope() = default;
+    Rope(Rope &&) = default;
+    Rope &operator=(Rope &&) = default;
+
+    Rope(const Rope &) = delete;
+    Rope &operator=(const Rope &) = delete;
+
+    void append(std::string_view s);
+
+    /**
+     * @brief splice: Moves the contents of other to the end of this rope, leaving other empty.
+     */
+    void splice(Rope &other);
+
+    template <typename T>
+    Rope &operator<<(const T &v) {
+        if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+            append(v);
+        } else {
+            append(fmt::to_string(v));
+        }
+        return *this;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear();
+
+    /**
+     * @brief str: The whole text in one string.
+     */
+    std::string str() const;
+
+    /**
+     * @brief write: Writes the chunks one after the other, without joining them first.
+     */
+    void write(std::ostream &out) const;
+
+private:
+    std::list<std::string> m_chunks;
+    size_t m_size = 0;
+};
+
+#endif // KIRAZ_ROPE_H
@@ -0,0 +1,154 @@
+
+#include "Server.h"
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace server {
+
+namespace {
+
+enum Status {
+    OK,
+    ERR,
+};
+
+bool read_line(FILE *in, std::string &line) {
+    line.clear();
+    for (int c; (c = std::getc(in)) != EOF;) {
+        if (c == '\n') {
+            return true;
+        }
+        line.push_back(char(c));
+    }
+    return ! line.empty();
+}
+
+void write_response(FILE *out, int status, std::string_view output, std::string_view error,
+        std::string_view report) {
+    fmt::print(out, "{} {} {} {}\n", status, output.size(), error.size(), report.size());
+    std::fwrite(output.data(), 1, output.size(), out);
+    std::fwrite(error.data(), 1, error.size(), out);
+    std::fwrite(report.data(), 1, report.size(), out);
+    std::fflush(out);
+}
+
+void serve_request(Compiler &compiler, const Request &request, FILE *out) {
+    compiler.reset();
+    compiler.set_output(request.output);
+    compiler.set_optimize(request.optimize);
+
+    TimeReport report;
+    compiler.set_report(request.report ? &report : nullptr);
+
+    auto status = request.is_file ? compiler.compile_file(request.payload)
+                                  : compiler.compile_string(request.payload);
+    compiler.set_report(nullptr);
+
+    std::string output;
+    if (status == OK && request.output == Compiler::Output::Wasm) {
+        const auto &wasm = compiler.get_wasm();
+        output.assign(wasm.begin(), wasm.end());
+    } else if (status == OK) {
+        output = compiler.get_wasm_ctx().body().str();
+    }
+
+    std::string json;
+    if (request.report) {
+        json = report.format_json(request.is_file ? request.payload : "<source>");
+    }
+
+    write_response(out, status, output, compiler.get_error(), json);
+}
+
+} // namespace
+
+bool parse_request(std::string_view header, FILE *in, Request &request, std::string &error) {
+    error = FF("malformed request: {}\n", header);
+
+    std::vector<std::string_view> words;
+    for (size_t pos = 0; pos < header.size();) {
+        auto end = std::min(header.find(' ', pos), header.size());
+        if (end > pos) {
+            words.push_back(header.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    if (words.size() < 2) {
+        return false;
+    }
+
+    if (words.front() == "file") {
+        request.is_file = true;
+    } else if (words.front() != "source") {
+        return false;
+    }
+
+    for (size_t i = 1; i + 1 < words.size(); ++i) {
+        if (words[i] == "wat") {
+            request.output = Compiler::Output::Wat;
+        } else if (words[i] == "wasm") {
+            request.output = Compiler::Output::Wasm;
+        } else if (words[i].starts_with('O')) {
+            if (! opt::parse_level(words[i].substr(1), request.optimize)) {
+                return false;
+            }
+        } else if (words[i] == "time-report") {
+            request.report = true;
+        } else {
+            return false;
+        }
+    }
+
+    size_t size;
+    auto arg = words.back();
+    auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), size);
+    if (ec != std::errc() || ptr != arg.data() + arg.size()) {
+        return false;
+    }
+    if (size > MaxPayload) {
+        error = FF("request too large: {} bytes, at most {} are accepted\n", size, MaxPayload);
+        return false;
+    }
+
+    request.payload.resize(size);
+    if (std::fread(request.payload.data(), 1, size, in) != size) {
+        error = FF("request cut short: {} bytes expected\n", size);
+        return false;
+    }
+    return true;
+}
+
+bool serve(Compiler &compiler, Compiler::Output output, const opt::Options &optimize, FILE *in,
+        FILE *out) {
+    for (std::string header; read_line(in, header);) {
+        if (header == "quit") {
+            return true;
+        }
+
+        Request request;
+        request.output = output;
+        request.optimize = optimize;
+        std::string error;
+        if (! parse_request(header, in, request, error)) {
+            // the framing is lost, so is the rest of the input
+            write_response(out, ERR, {}, error, {});
+            return false;
+        }
+
+        // a failing request must not take the server down with it, the next one starts from a
+        // reset compiler
+        try {
+            serve_request(compiler, request, out);
+        } catch (const std::exception &e) {
+            write_response(out, ERR, {}, FF("internal error: {}\n", e.what()), {});
+        }
+    }
+    return false;
+}
+
+} // namespace server
@@ -0,0 +1,59 @@
+#ifndef KIRAZ_SERVER_H
+#define KIRAZ_SERVER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include <kiraz/Compiler.h>
+
+/**
+ * Server mode: one compiler stays up and serves request after request, so the prelude is loaded
+ * and the symbols are interned only once. Both directions are framed as a header line followed
+ * by raw bytes, so that neither sources nor wasm binaries need escaping:
+ *
+ *   request:  source|file [wat|wasm] [O<level>] [time-report] <size>\n<source or file path>
+ *   response: <status> <output size> <diagnostics size> <report size>\n
+ *             <output><diagnostics><report>
+ *
+ * A status of 0 means success, the report is the json time report if one was asked for. Requests
+ * without an output format or optimization level get the defaults of the server. The server stops
+ * at the end of its input or on a "quit" line.
+ */
+namespace server {
+
+struct Request {
+    bool is_file = false;
+    Compiler::Output output = Compiler::Output::Wat;
+    opt::Options optimize;
+    bool report = false;
+    std::string payload;
+};
+
+/**
+ * @brief MaxPayload: The largest source or file path a request can carry. The size comes from the
+ *        client, so it is checked before any memory is allocated for it.
+ */
+inline constexpr size_t MaxPayload = size_t(64) << 20;
+
+/**
+ * @brief parse_request: Reads the payload of the request with the given header line from in.
+ *        The output format and optimization level of the request are left alone unless the
+ *        header names them.
+ * @return false with the reason in error if the header is malformed, the payload too large or
+ *         cut short.
+ */
+bool parse_request(std::string_view header, FILE *in, Request &request, std::string &error);
+
+/**
+ * @brief serve: Answers the requests read from in until it ends. A malformed request is answered
+ *        with an error and ends the session, as the framing of what follows it is lost.
+ * @return true if the client asked the server to quit.
+ */
+bool serve(Compiler &compiler, Compiler::Output output, const opt::Options &optimize, FILE *in,
+        FILE *out);
+
+} // namespace server
+
+#endif // KIRAZ_SERVER_H
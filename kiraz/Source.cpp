@@ -0,0 +1,134 @@
+
+#include "Source.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<Source> Source::copy(std::string_view text) {
+    std::unique_ptr<Source> retval(new Source);
+    retval->m_data = new char[text.size() + 2];
+    retval->m_size = text.size();
+    std::memcpy(retval->m_data, text.data(), text.size());
+    retval->m_data[text.size()] = retval->m_data[text.size() + 1] = '\0';
+    return retval;
+}
+
+#ifdef _WIN32
+
+std::unique_ptr<Source> Source::map_file(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    if (! f) {
+        errno = ENOENT;
+        return nullptr;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    return copy(text);
+}
+
+#else
+
+/**
+ * @brief read_fd: Reads what is left of the given file descriptor into a padded copy.
+ * @return nullptr with errno set on a read error.
+ */
+static std::unique_ptr<Source> read_fd(int fd) {
+    std::string text;
+    char chunk[65536];
+    for (;;) {
+        auto n = read(fd, chunk, sizeof(chunk));
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return nullptr;
+        }
+        text.append(chunk, n);
+    }
+    return Source::copy(text);
+}
+
+std::unique_ptr<Source> Source::map_file(const std::string &path) {
+    int fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        auto err = errno;
+        close(fd);
+        errno = err;
+        return nullptr;
+    }
+
+    // pipes and other special files have no size to map, they are read up to their end instead
+    if (! S_ISREG(st.st_mode)) {
+        auto retval = read_fd(fd);
+        auto err = errno;
+        close(fd);
+        errno = err;
+        return retval;
+    }
+
+    size_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return copy({});
+    }
+
+    /*
+     * Reserve room for the file plus the two NULs with an anonymous mapping, then map the file
+     * over its start. Whatever follows the end of the file, in its last page or in the
+     * anonymous pages after it, reads as zero. MAP_PRIVATE keeps flex's writes to ourselves.
+     */
+    auto length = size + 2;
+    auto base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        auto err = errno;
+        close(fd);
+        errno = err;
+        return nullptr;
+    }
+
+    auto file = mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    auto err = errno;
+    close(fd);
+    if (file == MAP_FAILED) {
+        munmap(base, length);
+        errno = err;
+        return nullptr;
+    }
+
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    std::unique_ptr<Source> retval(new Source);
+    retval->m_data = static_cast<char *>(base);
+    retval->m_size = size;
+    retval->m_mapped = length;
+    return retval;
+}
+
+#endif
+
+Source::~Source() {
+#ifndef _WIN32
+    if (m_mapped) {
+        munmap(m_data, m_mapped);
+        return;
+    }
+#endif
+    delete[] m_data;
+}
@@ -0,0 +1,49 @@
+#ifndef KIRAZ_SOURCE_H
+#define KIRAZ_SOURCE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Source: Input text for the lexer, laid out the way flex's yy_scan_buffer wants it:
+ *        writable and followed by two NUL bytes, so it can be scanned in place. Files are mapped
+ *        instead of read, which means token spans point straight into the mapping.
+ */
+class Source {
+public:
+    /**
+     * @brief map_file: Maps the given file privately into memory. Files that can not be mapped,
+     *        like pipes, are read into a copy instead.
+     * @return nullptr with errno set if the file could not be opened, mapped or read.
+     */
+    static std::unique_ptr<Source> map_file(const std::string &path);
+
+    /**
+     * @brief copy: Makes a padded copy of the given text. flex writes into the buffer while
+     *        scanning, so text we do not own can not be scanned in place.
+     */
+    static std::unique_ptr<Source> copy(std::string_view text);
+
+    Source(const Source &) = delete;
+    Source &operator=(const Source &) = delete;
+    ~Source();
+
+    std::string_view text() const { return {m_data, m_size}; }
+
+    /**
+     * @brief buffer, buffer_size: The arguments to pass to yy_scan_buffer. The size includes
+     *        the two terminating NULs.
+     */
+    char *buffer() { return m_data; }
+    size_t buffer_size() const { return m_size + 2; }
+
+private:
+    Source() = default;
+
+    char *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapped = 0;
+};
+
+#endif // KIRAZ_SOURCE_H
@@ -0,0 +1,95 @@
+
+#include "Symbol.h"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace {
+/**
+ * @brief Interner: Strings are stored in fixed-size chunks that are never moved or freed, so str()
+ *        finds one with two indexings and no lock. Only interning takes the mutex.
+ */
+struct Interner {
+    static constexpr uint32_t ChunkBits = 12;
+    static constexpr uint32_t ChunkSize = 1u << ChunkBits;
+    static constexpr uint32_t MaxChunks = 1u << 16;
+
+    Interner() {
+        add("");
+#define X(id, str) add(str);
+        KIRAZ_BUILTIN_SYMBOLS(X)
+#undef X
+    }
+
+    const std::string &at(uint32_t id) const {
+        return chunks[id >> ChunkBits][id & (ChunkSize - 1)];
+    }
+
+    /**
+     * @brief add: Stores a new string. Needs the unique lock once other threads can see the
+     *        interner.
+     */
+    uint32_t add(std::string_view s) {
+        auto id = size.load(std::memory_order_relaxed);
+        if (id == MaxChunks * ChunkSize) {
+            throw std::length_error("Too many symbols");
+        }
+
+        auto &chunk = chunks[id >> ChunkBits];
+        if (! chunk) {
+            chunk = std::make_unique<std::string[]>(ChunkSize);
+        }
+
+        const auto &stored = chunk[id & (ChunkSize - 1)] = s;
+        index.emplace(stored, id);
+
+        // the string and its chunk are written before the new size is visible to readers
+        size.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    std::array<std::unique_ptr<std::string[]>, MaxChunks> chunks;
+    std::atomic<uint32_t> size = 0;
+
+    // views into chunks, guarded by mutex; compilers on different threads share the interner
+    std::unordered_map<std::string_view, uint32_t> index;
+    std::shared_mutex mutex;
+};
+
+Interner &interner() {
+    static Interner s_interner;
+    return s_interner;
+}
+} // namespace
+
+Symbol Symbol::intern(std::string_view s) {
+    auto &in = interner();
+    {
+        std::shared_lock lock(in.mutex);
+        if (auto iter = in.index.find(s); iter != in.index.end()) {
+            return Symbol(iter->second);
+        }
+    }
+
+    std::unique_lock lock(in.mutex);
+    if (auto iter = in.index.find(s); iter != in.index.end()) {
+        return Symbol(iter->second);
+    }
+    return Symbol(in.add(s));
+}
+
+std::string_view Symbol::str() const {
+    auto &in = interner();
+
+    // pairs with the release in add, for symbols that reached this thread without a lock
+    [[maybe_unused]] auto size = in.size.load(std::memory_order_acquire);
+    assert(m_id < size);
+    return in.at(m_id);
+}
@@ -0,0 +1,83 @@
+#ifndef KIRAZ_SYMBOL_H
+#define KIRAZ_SYMBOL_H
+
+#include <cstdint>
+#include <string_view>
+
+#include <fmt/format.h>
+
+/*
+ * Names the compiler itself needs to recognize. They are interned first, in this order, so their
+ * symbol ids are compile time constants: sym::Integer64 etc.
+ */
+#define KIRAZ_BUILTIN_SYMBOLS(X)                                                                   \
+    X(And, "and")                                                                                  \
+    X(Or, "or")                                                                                    \
+    X(Not, "not")                                                                                  \
+    X(True, "true")                                                                                \
+    X(False, "false")                                                                              \
+    X(Boolean, "Boolean")                                                                          \
+    X(Integer64, "Integer64")                                                                      \
+    X(String, "String")                                                                            \
+    X(Void, "Void")                                                                                \
+    X(Class, "Class")                                                                              \
+    X(Module, "Module")
+
+namespace sym {
+enum Builtin : uint32_t {
+    Empty = 0,
+#define X(id, str) id,
+    KIRAZ_BUILTIN_SYMBOLS(X)
+#undef X
+    BuiltinCount,
+};
+} // namespace sym
+
+/**
+ * @brief Symbol: Handle to a string in the process-wide string interner. Two symbols are equal
+ *        iff their strings are equal, so comparing and hashing them is an integer operation.
+ *        The default-constructed symbol refers to the empty string.
+ */
+class Symbol {
+public:
+    Symbol() = default;
+    constexpr Symbol(sym::Builtin b) : m_id(b) {}
+
+    /**
+     * @brief intern: Returns the symbol for the given string, adding it to the interner if it is
+     *        not there yet. The string is copied, so the argument does not need to outlive the
+     *        call.
+     */
+    static Symbol intern(std::string_view s);
+
+    /**
+     * @brief str: Returns the interned string. The view is valid for the lifetime of the process.
+     */
+    std::string_view str() const;
+
+    constexpr auto get_id() const { return m_id; }
+    constexpr bool empty() const { return m_id == 0; }
+    constexpr bool is_builtin() const { return m_id != 0 && m_id < sym::BuiltinCount; }
+
+    bool operator==(const Symbol &) const = default;
+    auto operator<=>(const Symbol &) const = default;
+
+private:
+    explicit constexpr Symbol(uint32_t id) : m_id(id) {}
+
+    uint32_t m_id = 0;
+};
+
+template <>
+struct std::hash<Symbol> {
+    size_t operator()(const Symbol &s) const noexcept { return s.get_id(); }
+};
+
+template <>
+struct fmt::formatter<Symbol> : fmt::formatter<std::string_view> {
+    format_context::iterator format(const Symbol &sym, format_context &ctx) const {
+        return fmt::formatter<std::string_view>::format(sym.str(), ctx);
+    }
+};
+
+#endif // KIRAZ_SYMBOL_H
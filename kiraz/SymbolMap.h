@@ -0,0 +1,126 @@
+#ifndef KIRAZ_SYMBOLMAP_H
+#define KIRAZ_SYMBOLMAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <kiraz/Symbol.h>
+
+/**
+ * @brief SymbolMap: Hash map keyed by interned symbols. Entries are kept in a dense vector in
+ *        order of insertion, which is also the order of iteration, so anything derived from
+ *        walking a map is deterministic. Lookups go through a flat open addressing index of
+ *        (symbol id, entry) pairs with linear probing, so a hit usually touches one cache line
+ *        of the index and then the entry itself. Entries are never removed.
+ */
+template <typename T>
+class SymbolMap {
+public:
+    using value_type = std::pair<Symbol, T>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    iterator find(Symbol key) {
+        auto slot = lookup(key);
+        return slot ? m_entries.begin() + slot->index : m_entries.end();
+    }
+
+    const_iterator find(Symbol key) const {
+        auto slot = lookup(key);
+        return slot ? m_entries.begin() + slot->index : m_entries.end();
+    }
+
+    bool contains(Symbol key) const { return lookup(key); }
+
+    /**
+     * @brief operator[]: The value for the given key, default constructed if it is new.
+     */
+    T &operator[](Symbol key) {
+        if (auto slot = lookup(key)) {
+            return m_entries[slot->index].second;
+        }
+        return insert_new(key, T{});
+    }
+
+    auto begin() { return m_entries.begin(); }
+    auto end() { return m_entries.end(); }
+    auto begin() const { return m_entries.begin(); }
+    auto end() const { return m_entries.end(); }
+
+    auto size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+
+    void clear() {
+        m_entries.clear();
+        m_slots.clear();
+    }
+
+private:
+    struct Slot {
+        uint32_t id = Free;
+        uint32_t index = 0;
+    };
+
+    static constexpr uint32_t Free = UINT32_MAX;
+    static constexpr size_t MinSlots = 8;
+
+    // Symbol ids are dense and small, Fibonacci hashing spreads neighbours apart. The slot comes
+    // from the top bits of the product, the ones every bit of the id feeds into.
+    size_t home(uint32_t id) const { return (id * 2654435769u) >> m_shift; }
+
+    const Slot *lookup(Symbol key) const {
+        if (m_slots.empty()) {
+            return nullptr;
+        }
+
+        for (auto i = home(key.get_id());; i = (i + 1) & (m_slots.size() - 1)) {
+            const auto &slot = m_slots[i];
+            if (slot.id == key.get_id()) {
+                return &slot;
+            }
+            if (slot.id == Free) {
+                return nullptr;
+            }
+        }
+    }
+
+    T &insert_new(Symbol key, T &&value) {
+        assert(key.get_id() != Free);
+
+        // keep the load factor at or below 1/2
+        if ((m_entries.size() + 1) * 2 > m_slots.size()) {
+            rehash(std::max(MinSlots, m_slots.size() * 2));
+        }
+
+        m_entries.emplace_back(key, std::move(value));
+        place(key.get_id(), m_entries.size() - 1);
+        return m_entries.back().second;
+    }
+
+    void place(uint32_t id, uint32_t index) {
+        auto i = home(id);
+        while (m_slots[i].id != Free) {
+            i = (i + 1) & (m_slots.size() - 1);
+        }
+        m_slots[i] = {id, index};
+    }
+
+    void rehash(size_t size) {
+        assert(std::has_single_bit(size));
+        m_slots.assign(size, Slot{});
+        m_shift = 32 - std::countr_zero(size);
+        for (uint32_t i = 0; i < m_entries.size(); ++i) {
+            place(m_entries[i].first.get_id(), i);
+        }
+    }
+
+    std::vector<value_type> m_entries;
+    std::vector<Slot> m_slots;
+    int m_shift = 32;
+};
+
+#endif // KIRAZ_SYMBOLMAP_H
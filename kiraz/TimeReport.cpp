@@ -0,0 +1,219 @@
+
+#include "TimeReport.h"
+
+#include <ctime>
+#include <iterator>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <fmt/format.h>
+
+#ifdef _WIN32
+
+static std::chrono::nanoseconds thread_cpu_time() {
+    FILETIME creation, exit, kernel, user;
+    if (! GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return {};
+    }
+
+    // both are in units of 100 ns
+    auto ticks = [](const FILETIME &ft) {
+        return (uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    };
+    return std::chrono::nanoseconds((ticks(kernel) + ticks(user)) * 100);
+}
+
+#else
+
+static std::chrono::nanoseconds thread_cpu_time() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+#endif
+
+static double to_ms(std::chrono::nanoseconds ns) {
+    return std::chrono::duration<double, std::milli>(ns).count();
+}
+
+TimeReport::Timer::Timer(TimeReport *report, Phase phase) : m_report(report), m_phase(phase) {
+    if (m_report) {
+        m_wall = std::chrono::steady_clock::now();
+        m_cpu = thread_cpu_time();
+    }
+}
+
+TimeReport::Timer::~Timer() {
+    if (m_report) {
+        auto &times = m_report->m_times[size_t(m_phase)];
+        times.wall += std::chrono::steady_clock::now() - m_wall;
+        times.cpu += thread_cpu_time() - m_cpu;
+        ++times.runs;
+    }
+}
+
+void TimeReport::merge(const TimeReport &other) {
+    for (size_t i = 0; i < NumPhases; ++i) {
+        m_times[i].wall += other.m_times[i].wall;
+        m_times[i].cpu += other.m_times[i].cpu;
+        m_times[i].runs += other.m_times[i].runs;
+    }
+
+    m_counts.tokens += other.m_counts.tokens;
+    m_counts.nodes += other.m_counts.nodes;
+    m_counts.scopes += other.m_counts.scopes;
+    m_counts.symbols += other.m_counts.symbols;
+    m_counts.bytes += other.m_counts.bytes;
+}
+
+TimeReport TimeReport::best_of(const TimeReport &a, const TimeReport &b) {
+    auto retval = a;
+    for (size_t i = 0; i < NumPhases; ++i) {
+        if (b.m_times[i].wall < a.m_times[i].wall) {
+            retval.m_times[i] = b.m_times[i];
+        }
+    }
+    return retval;
+}
+
+std::string_view TimeReport::get_name(Phase phase) {
+    switch (phase) {
+    case Phase::Total:
+        return "total";
+    case Phase::Parse:
+        return "parse";
+    case Phase::Scan:
+        return "scan";
+    case Phase::Prelude:
+        return "prelude";
+    case Phase::Check:
+        return "check";
+    case Phase::Optimize:
+        return "optimize";
+    case Phase::Codegen:
+        return "codegen";
+    case Phase::Encode:
+        return "encode";
+    }
+    return "?";
+}
+
+#ifdef _WIN32
+
+size_t TimeReport::get_peak_rss() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (! GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
+#else
+
+size_t TimeReport::get_peak_rss() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * size_t(1024);
+#endif
+}
+
+#endif
+
+std::string TimeReport::format_text(std::string_view input) const {
+    fmt::memory_buffer out;
+    auto it = std::back_inserter(out);
+
+    fmt::format_to(it, "Time report for {}\n", input);
+    fmt::format_to(it, "  {:<10} {:>10} {:>10} {:>8}\n", "phase", "wall ms", "cpu ms", "runs");
+    for (size_t i = 0; i < NumPhases; ++i) {
+        auto phase = Phase(i);
+        const auto &times = m_times[i];
+        if (times.runs == 0) {
+            continue;
+        }
+
+        // scanning is part of parsing and has no cpu time of its own
+        if (phase == Phase::Scan) {
+            fmt::format_to(it, "    {:<8} {:>10.3f} {:>10} {:>8}\n", get_name(phase),
+                    to_ms(times.wall), "-", times.runs);
+            continue;
+        }
+        fmt::format_to(it, "  {:<10} {:>10.3f} {:>10.3f} {:>8}\n", get_name(phase),
+                to_ms(times.wall), to_ms(times.cpu), times.runs);
+    }
+
+    fmt::format_to(it, "  tokens {}, nodes {}, scopes {}, symbols {}, output {} bytes\n",
+            m_counts.tokens, m_counts.nodes, m_counts.scopes, m_counts.symbols, m_counts.bytes);
+    fmt::format_to(it, "  peak rss {} KiB\n", get_peak_rss() / 1024);
+    return fmt::to_string(out);
+}
+
+static void write_json_string(fmt::memory_buffer &out, std::string_view str) {
+    auto it = std::back_inserter(out);
+    out.push_back('"');
+    for (unsigned char c : str) {
+        switch (c) {
+        case '"':
+            out.append(std::string_view("\\\""));
+            break;
+        case '\\':
+            out.append(std::string_view("\\\\"));
+            break;
+        case '\n':
+            out.append(std::string_view("\\n"));
+            break;
+        default:
+            if (c < 0x20) {
+                fmt::format_to(it, "\\u{:04x}", c);
+            }
+            else {
+                out.push_back(c);
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+std::string TimeReport::format_json(std::string_view input) const {
+    fmt::memory_buffer out;
+    auto it = std::back_inserter(out);
+
+    out.append(std::string_view("{\"input\":"));
+    write_json_string(out, input);
+
+    out.append(std::string_view(",\"phases\":{"));
+    bool first = true;
+    for (size_t i = 0; i < NumPhases; ++i) {
+        auto phase = Phase(i);
+        const auto &times = m_times[i];
+        if (times.runs == 0) {
+            continue;
+        }
+
+        fmt::format_to(it, "{}\"{}\":{{\"wall_ms\":{:.6f}", first ? "" : ",", get_name(phase),
+                to_ms(times.wall));
+        if (phase != Phase::Scan) {
+            fmt::format_to(it, ",\"cpu_ms\":{:.6f}", to_ms(times.cpu));
+        }
+        fmt::format_to(it, ",\"runs\":{}}}", times.runs);
+        first = false;
+    }
+
+    fmt::format_to(it,
+            "}},\"tokens\":{},\"nodes\":{},\"scopes\":{},\"symbols\":{},\"bytes\":{},"
+            "\"peak_rss\":{}}}",
+            m_counts.tokens, m_counts.nodes, m_counts.scopes, m_counts.symbols, m_counts.bytes,
+            get_peak_rss());
+    return fmt::to_string(out);
+}
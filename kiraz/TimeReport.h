@@ -0,0 +1,113 @@
+#ifndef KIRAZ_TIMEREPORT_H
+#define KIRAZ_TIMEREPORT_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief TimeReport: Where one compilation spent its time and what it produced. The compiler
+ *        fills it in when one is attached with Compiler::set_report(); nothing is measured
+ *        otherwise.
+ *
+ *        Wall and CPU time are kept per phase. CPU time is that of the compiling thread, so
+ *        reports of compilations running in parallel do not mix. Scanning happens on demand from
+ *        within the parser; its time is part of the parse phase and is only measured as wall
+ *        time, to keep the overhead per token low.
+ */
+class TimeReport {
+public:
+    enum class Phase : uint8_t {
+        Total,
+        Parse,
+        Scan,
+        Prelude,
+        Check,
+        Optimize,
+        Codegen,
+        Encode,
+    };
+
+    static constexpr size_t NumPhases = size_t(Phase::Encode) + 1;
+
+    struct Times {
+        std::chrono::nanoseconds wall{};
+        std::chrono::nanoseconds cpu{};
+        uint32_t runs = 0;
+    };
+
+    struct Counts {
+        size_t tokens = 0;
+        size_t nodes = 0;
+        size_t scopes = 0;
+        size_t symbols = 0;
+        size_t bytes = 0; // of generated code, wat or wasm
+    };
+
+    /**
+     * @brief Timer: Adds the time between its construction and destruction to the given phase.
+     *        Does nothing without a report.
+     */
+    class Timer {
+    public:
+        Timer(TimeReport *report, Phase phase);
+        ~Timer();
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+    private:
+        TimeReport *m_report;
+        Phase m_phase;
+        std::chrono::steady_clock::time_point m_wall;
+        std::chrono::nanoseconds m_cpu;
+    };
+
+    /**
+     * @brief add_scan: Accounts for one call into the scanner, see ParseContext.
+     */
+    void add_scan(std::chrono::nanoseconds wall) {
+        auto &times = m_times[size_t(Phase::Scan)];
+        times.wall += wall;
+        ++times.runs;
+        ++m_counts.tokens;
+    }
+
+    const Times &get(Phase phase) const { return m_times[size_t(phase)]; }
+    auto &counts() { return m_counts; }
+    const auto &counts() const { return m_counts; }
+
+    /**
+     * @brief merge: Adds the times and counts of another report to this one.
+     */
+    void merge(const TimeReport &other);
+
+    /**
+     * @brief best_of: For two reports of the same work, the faster time of each phase.
+     */
+    static TimeReport best_of(const TimeReport &a, const TimeReport &b);
+
+    static std::string_view get_name(Phase phase);
+
+    /**
+     * @brief get_peak_rss: Peak resident set size of the whole process, in bytes. On Windows,
+     *        the peak working set.
+     */
+    static size_t get_peak_rss();
+
+    /**
+     * @brief format_text, format_json: The report for the given input, for people and for
+     *        tools. The JSON form is a single object on one line.
+     */
+    std::string format_text(std::string_view input) const;
+    std::string format_json(std::string_view input) const;
+
+private:
+    std::array<Times, NumPhases> m_times{};
+    Counts m_counts;
+};
+
+#endif // KIRAZ_TIMEREPORT_H
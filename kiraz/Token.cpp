@@ -1,5 +1,29 @@
 
 #include "Token.h"
 
-int Token::colno;
-Token::~Token() {}
+#include <kiraz/token/Literal.h>
+#include <kiraz/token/Operator.h>
+#include <kiraz/token/keyword.h>
+
+std::string Token::as_string() const {
+    switch (m_id) {
+    case L_INTEGER:
+        return token::Integer(*this).as_string();
+    case IDENTIFIER:
+        return token::Identifier(*this).as_string();
+    case L_STRING:
+        return token::StringLiteral(*this).as_string();
+    case YYUNDEF:
+        return fmt::format("REJECTED({})", m_text);
+    default:
+        break;
+    }
+
+    if (auto name = token::operator_name(m_id)) {
+        return name;
+    }
+    if (auto name = token::keyword_name(m_id)) {
+        return name;
+    }
+    return fmt::format("TOKEN({})", m_id);
+}
@@ -1,44 +1,41 @@
 #ifndef KIRAZ_TOKEN_H
 #define KIRAZ_TOKEN_H
 
+#include <string_view>
+
 #include "main.h"
 
+#include <kiraz/Symbol.h>
+
+/**
+ * @brief Token: What the lexer hands to the parser. This is a trivially copyable value; the text
+ *        is a span into the lexer's input buffer and is only valid until the buffer is released,
+ *        so AST nodes must copy or intern whatever they keep. Identifiers carry their interned
+ *        symbol as well.
+ */
 class Token {
 public:
-    using Ptr = std::shared_ptr<Token>;
-    using Cptr = std::shared_ptr<const Token>;
-
-    Token(int id) : m_id(id) {}
-    virtual ~Token();
-
-    virtual std::string as_string() const = 0;
-    void print() { fmt::print("{}\n", as_string()); }
-
-    template <typename T>
-    static auto New() {
-        return std::make_shared<T>();
-    }
+    Token() = default;
+    Token(int id, std::string_view text, int line, int col, Symbol sym = {})
+            : m_id(id), m_line(line), m_col(col), m_sym(sym), m_text(text) {}
 
-    template <typename T, typename... Args>
-    static auto New(Args &&...args) {
-        return std::make_shared<T>(std::forward<Args>(args)...);
-    }
+    std::string as_string() const;
+    void print() const { fmt::print("{}\n", as_string()); }
 
-    static int colno;
+    int get_id() const { return m_id; }
+    auto get_text() const { return m_text; }
+    auto get_symbol() const { return m_sym; }
+    auto get_line() const { return m_line; }
+    auto get_col() const { return m_col; }
 
-    virtual int get_id() const { return m_id; }
-
-private:
-    int m_id;
-};
-
-class Rejected : public Token {
-public:
-    Rejected(const char *text) : Token(YYUNDEF), m_text(text) {}
-    std::string as_string() const override { return fmt::format("REJECTED({})", m_text); }
+    explicit operator bool() const { return m_id != YYEMPTY; }
 
 private:
-    std::string m_text;
+    int m_id = YYEMPTY;
+    int m_line = 0;
+    int m_col = 0;
+    Symbol m_sym;
+    std::string_view m_text;
 };
 
 namespace token {
@@ -0,0 +1,89 @@
+
+#include "Type.h"
+
+#include <cassert>
+
+#include <fmt/format.h>
+
+const Type Type::Void(Kind::Void, sym::Void);
+const Type Type::Boolean(Kind::Boolean, sym::Boolean);
+const Type Type::Integer64(Kind::Integer64, sym::Integer64);
+const Type Type::String(Kind::String, sym::String);
+
+const Type *Type::get_builtin(Symbol name) {
+    if (! name.is_builtin()) {
+        return nullptr;
+    }
+
+    switch (sym::Builtin(name.get_id())) {
+    case sym::Void:
+        return &Void;
+    case sym::Boolean:
+        return &Boolean;
+    case sym::Integer64:
+        return &Integer64;
+    case sym::String:
+        return &String;
+    default:
+        return nullptr;
+    }
+}
+
+std::string Type::as_string() const {
+    if (m_kind != Kind::Func) {
+        return std::string(m_name.str());
+    }
+
+    std::string params;
+    for (auto param : m_params) {
+        if (! params.empty()) {
+            params += ", ";
+        }
+        params += param->as_string();
+    }
+    return fmt::format("({}) -> {}", params, m_result->as_string());
+}
+
+const Type *TypeTable::get_class(Symbol name, const Node *decl) {
+    auto [iter, added] = m_classes.try_emplace(decl, nullptr);
+    if (added) {
+        auto &type = m_types.emplace_back(Type(Type::Kind::Class, name));
+        type.m_decl = decl;
+        iter->second = &type;
+    }
+    return iter->second;
+}
+
+bool Type::converts_to(const Type *other) const {
+    for (auto type = this; type; type = type->m_base) {
+        if (type == other) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TypeTable::set_base(const Type *type, const Type *base) {
+    assert(type->get_kind() == Type::Kind::Class && m_classes.count(type->get_decl()));
+    assert(! base->converts_to(type));
+
+    // the types are made and owned by this table
+    const_cast<Type *>(type)->m_base = base;
+}
+
+const Type *TypeTable::get_func(const std::vector<const Type *> &params, const Type *result) {
+    auto [iter, added] = m_funcs.try_emplace({params, result}, nullptr);
+    if (added) {
+        auto &type = m_types.emplace_back(Type(Type::Kind::Func, {}));
+        type.m_params = params;
+        type.m_result = result;
+        iter->second = &type;
+    }
+    return iter->second;
+}
+
+void TypeTable::clear() {
+    m_funcs.clear();
+    m_classes.clear();
+    m_types.clear();
+}
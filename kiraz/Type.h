@@ -0,0 +1,118 @@
+#ifndef KIRAZ_TYPE_H
+#define KIRAZ_TYPE_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <kiraz/Symbol.h>
+
+class Node;
+
+/**
+ * @brief Type: A type as the semantic checks and code generation see it. Types are canonical:
+ *        there is exactly one object per type, so two types are the same iff their pointers are
+ *        equal. The builtin types are static; class and function types are made by a TypeTable.
+ */
+class Type {
+public:
+    enum class Kind : uint8_t {
+        Void,
+        Boolean,
+        Integer64,
+        String,
+        Class,
+        Func,
+    };
+
+    static const Type Void;
+    static const Type Boolean;
+    static const Type Integer64;
+    static const Type String;
+
+    /**
+     * @brief get_builtin: The builtin type with the given name, or nullptr.
+     */
+    static const Type *get_builtin(Symbol name);
+
+    auto get_kind() const { return m_kind; }
+    auto get_name() const { return m_name; }
+
+    /**
+     * @brief get_decl: The ClassNode of a class type.
+     */
+    auto get_decl() const { return m_decl; }
+
+    /**
+     * @brief get_base: The class a class type derives from, nullptr if there is none.
+     */
+    auto get_base() const { return m_base; }
+
+    /**
+     * @brief converts_to: Whether a value of this type can be used where the given type is
+     *        expected, which it can if the types are the same or this class derives from it.
+     */
+    bool converts_to(const Type *other) const;
+
+    /**
+     * @brief get_params, get_result: Signature of a function type.
+     */
+    const auto &get_params() const { return m_params; }
+    auto get_result() const { return m_result; }
+
+    std::string as_string() const;
+
+private:
+    friend class TypeTable;
+
+    Type(Kind kind, Symbol name) : m_kind(kind), m_name(name) {}
+
+    Kind m_kind;
+    Symbol m_name;
+    const Node *m_decl = nullptr;
+    const Type *m_base = nullptr;
+    std::vector<const Type *> m_params;
+    const Type *m_result = nullptr;
+};
+
+/**
+ * @brief TypeTable: Makes the class and function types of one compilation, each exactly once.
+ *        Types stay valid as long as the table.
+ */
+class TypeTable {
+public:
+    /**
+     * @brief get_class: The type of the class declared by the given node.
+     */
+    const Type *get_class(Symbol name, const Node *decl);
+
+    /**
+     * @brief set_base: Records the class the given class type derives from.
+     */
+    void set_base(const Type *type, const Type *base);
+
+    /**
+     * @brief get_func: The function type with the given signature.
+     */
+    const Type *get_func(const std::vector<const Type *> &params, const Type *result);
+
+    void clear();
+
+private:
+    std::deque<Type> m_types;
+    std::unordered_map<const Node *, const Type *> m_classes;
+    std::map<std::pair<std::vector<const Type *>, const Type *>, const Type *> m_funcs;
+};
+
+template <>
+struct fmt::formatter<Type> : fmt::formatter<std::string> {
+    format_context::iterator format(const Type &type, format_context &ctx) const {
+        return fmt::formatter<std::string>::format(type.as_string(), ctx);
+    }
+};
+
+#endif // KIRAZ_TYPE_H
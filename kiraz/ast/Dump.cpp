@@ -0,0 +1,75 @@
+
+#include "Dump.h"
+
+#include <kiraz/ast/Visit.h>
+
+namespace ast {
+
+Dumper &Dumper::operator<<(std::string_view text) {
+    // nothing is queued before it, so it can be written right away
+    if (m_pending.empty()) {
+        m_out.append(text);
+    }
+    else {
+        m_pending.push_back({Item::Tag::Text, text});
+    }
+    return *this;
+}
+
+Dumper &Dumper::operator<<(int64_t value) {
+    if (m_pending.empty()) {
+        fmt::format_to(std::back_inserter(m_out), "{}", value);
+    }
+    else {
+        m_pending.push_back({Item::Tag::Number, {}, value});
+    }
+    return *this;
+}
+
+Dumper &Dumper::operator<<(Node::Cptr node) {
+    assert(node);
+    m_pending.push_back({Item::Tag::Node, {}, 0, node});
+    return *this;
+}
+
+Dumper &Dumper::list(const std::vector<Node::Ptr> &nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (i > 0) {
+            *this << ", ";
+        }
+        *this << nodes[i];
+    }
+    return *this;
+}
+
+void Dumper::write(const Item &item) {
+    switch (item.tag) {
+    case Item::Tag::Text:
+        m_out.append(item.text);
+        break;
+    case Item::Tag::Number:
+        fmt::format_to(std::back_inserter(m_out), "{}", item.value);
+        break;
+    case Item::Tag::Node:
+        visit(*item.node, [this](const auto &node) { node.dump(*this); });
+        m_stack.insert(m_stack.end(), m_pending.rbegin(), m_pending.rend());
+        m_pending.clear();
+        break;
+    }
+}
+
+void Dumper::run(const Node &root) {
+    assert(m_stack.empty() && m_pending.empty());
+    write({Item::Tag::Node, {}, 0, &root});
+    while (! m_stack.empty()) {
+        auto item = m_stack.back();
+        m_stack.pop_back();
+        write(item);
+    }
+}
+
+void dump(const Node &root, fmt::memory_buffer &out) {
+    Dumper(out).run(root);
+}
+
+} // namespace ast
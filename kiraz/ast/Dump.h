@@ -0,0 +1,63 @@
+#ifndef KIRAZ_AST_DUMP_H
+#define KIRAZ_AST_DUMP_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <kiraz/Node.h>
+
+namespace ast {
+
+/**
+ * @brief Dumper: Writes the textual form of a tree into one buffer without recursion. A node
+ *        describes itself in its dump() method as a sequence of text and child nodes; children are
+ *        not written right away but queued on an explicit stack, so neither deep trees nor long
+ *        statement lists build intermediate strings or grow the call stack.
+ */
+class Dumper {
+public:
+    explicit Dumper(fmt::memory_buffer &out) : m_out(out) {}
+
+    /**
+     * @brief operator<<: Queues text, a number or a child node, in order. Text has to outlive the
+     *        dump, which holds for literals and for strings owned by the tree.
+     */
+    Dumper &operator<<(std::string_view text);
+    Dumper &operator<<(int64_t value);
+    Dumper &operator<<(Node::Cptr node);
+
+    /**
+     * @brief list: Queues the given nodes separated by commas.
+     */
+    Dumper &list(const std::vector<Node::Ptr> &nodes);
+
+    void run(const Node &root);
+
+private:
+    struct Item {
+        enum class Tag : uint8_t { Text, Number, Node };
+
+        Tag tag;
+        std::string_view text;
+        int64_t value = 0;
+        Node::Cptr node = nullptr;
+    };
+
+    void write(const Item &item);
+
+    fmt::memory_buffer &m_out;
+    std::vector<Item> m_stack;   // work left, the next item is at the back
+    std::vector<Item> m_pending; // items queued by the node being expanded
+};
+
+/**
+ * @brief dump: Appends the textual form of the tree rooted at the given node to the buffer.
+ */
+void dump(const Node &root, fmt::memory_buffer &out);
+
+} // namespace ast
+
+#endif // KIRAZ_AST_DUMP_H
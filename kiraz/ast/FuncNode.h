@@ -5,7 +5,7 @@
 #include <kiraz/Token.h>
 #include <vector>
 #include <memory>
-#include <unordered_set>
+#include <kiraz/ast/Dump.h>
 #include <kiraz/ast/Literal.h>
 #include <kiraz/Compiler.h>
 
@@ -13,22 +13,30 @@ namespace ast {
 
 class ArgNode : public Node {
 public:
-    ArgNode(Node::Ptr name, Node::Ptr type)
-        : Node(IDENTIFIER), m_name(name), m_type(type) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::ArgNode; }
 
-    std::string as_string() const override {
-        return fmt::format("FArg(n={}, t={})", 
-                           m_name ? m_name->as_string() : "null",
-                           m_type ? m_type->as_string() : "null");
+    ArgNode(Node::Ptr name, Node::Ptr type)
+        : Node(NodeKind::ArgNode, IDENTIFIER), m_name(name), m_type(type) {}
+
+    void dump(Dumper &out) const {
+        out << "FArg(n=";
+        m_name ? out << m_name : out << "null";
+        out << ", t=";
+        m_type ? out << m_type : out << "null";
+        out << ")";
     }
 
-    std::string get_type() const override {
-        return m_type ? m_type->as_string() : "";  
+    Symbol get_type() const override {
+        return name_of(m_type);
     }
 
     Node::Ptr get_name() const {
         return m_name;
     }
+
+    Node::Ptr get_type_name() const {
+        return m_type;
+    }
     
 private:
     Node::Ptr m_name;
@@ -38,12 +46,18 @@ private:
 
 class FuncArgs : public Node {
 public:
-    FuncArgs() : Node(OP_LPAREN) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::FuncArgs; }
+
+    FuncArgs() : Node(NodeKind::FuncArgs, OP_LPAREN) {}
     
     std::vector<Node::Ptr>& get_list() {
         return m_args;  
     }
 
+    const std::vector<Node::Ptr>& get_list() const {
+        return m_args;
+    }
+
     void add_argument(Node::Ptr arg) {
         m_args.push_back(arg);
     }
@@ -60,17 +74,20 @@ public:
     }
     
 
-    std::string as_string() const override {
-    if (m_args.empty()) {
-        return "[]";
-    }
-    std::string result = "FuncArgs([";
-    for (size_t i = 0; i < m_args.size(); ++i) {
-        result += m_args[i]->as_string();
-        if (i < m_args.size() - 1) result += ", ";
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        for (auto &arg : m_args) {
+            fn(arg);
+        }
     }
-    result += "])";
-    return result;
+
+    void dump(Dumper &out) const {
+        if (m_args.empty()) {
+            out << "[]";
+            return;
+        }
+        out << "FuncArgs([";
+        out.list(m_args) << "])";
     }
 
 private:
@@ -80,7 +97,9 @@ private:
 
 class NodeList : public Node {
 public:
-    NodeList() : Node(OP_LBRACE) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::NodeList; }
+
+    NodeList() : Node(NodeKind::NodeList, OP_LBRACE) {}
 
     void add_node(Node::Ptr node) {
         m_nodes.push_back(node);
@@ -90,14 +109,37 @@ public:
         return m_nodes;  
     }
 
-    std::string as_string() const override {
-        std::string result = "[";
-        for (size_t i = 0; i < m_nodes.size(); ++i) {
-            result += m_nodes[i]->as_string();
-            if (i < m_nodes.size() - 1) result += ", ";
+    const std::vector<Node::Ptr>& get_list() const {
+        return m_nodes;
+    }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        for (auto &node : m_nodes) {
+            fn(node);
         }
-        result += "]";
-        return result;
+    }
+
+    void dump(Dumper &out) const {
+        out << "[";
+        out.list(m_nodes) << "]";
+    }
+
+    /**
+     * @brief compute_stmt_type: Checks the statements in source order. Blocks do not open a scope,
+     *        their lets belong to the enclosing function.
+     */
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        for (const auto &stmt : m_nodes) {
+            if (auto ret = stmt->add_to_symtab_ordered(st)) {
+                return ret;
+            }
+            if (auto ret = stmt->compute_stmt_type(st)) {
+                return ret;
+            }
+        }
+        return nullptr;
     }
 
 private:
@@ -106,16 +148,22 @@ private:
 
 class FuncNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::FuncNode; }
+
     FuncNode(Node::Ptr name, Node::Ptr args, Node::Ptr returnType, Node::Ptr body)
-        : Node(KW_FUNC), m_name(name), m_args(args), 
+        : Node(NodeKind::FuncNode, KW_FUNC), m_name(name), m_args(args), 
           m_returnType(returnType), m_body(body) {}
 
-    std::string as_string() const override {
-        return fmt::format("Func(n={}, a={}, r={}, s={})",
-                           m_name ? m_name->as_string() : "null", 
-                           m_args ? m_args->as_string() : "[]", 
-                           m_returnType ? m_returnType->as_string() : "null", 
-                           m_body ? m_body->as_string() : "[]");
+    void dump(Dumper &out) const {
+        out << "Func(n=";
+        m_name ? out << m_name : out << "null";
+        out << ", a=";
+        m_args ? out << m_args : out << "[]";
+        out << ", r=";
+        m_returnType ? out << m_returnType : out << "null";
+        out << ", s=";
+        m_body ? out << m_body : out << "[]";
+        out << ")";
     }
 
     Node::Ptr get_return_type() const { 
@@ -126,98 +174,227 @@ public:
         return m_name; 
     }
 
+    Node::Ptr get_arg_list() const {
+        return m_args;
+    }
+
+    Node::Ptr get_body() const {
+        return m_body;
+    }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_body);
+    }
+
     size_t get_param_count() const {
-        if (auto args = std::dynamic_pointer_cast<FuncArgs>(m_args)) {
+        if (auto args = dyn_cast<FuncArgs>(m_args)) {
             return args->size(); 
         }
         return 0;
     }
 
-    std::string get_param_type(size_t index) const {
-        if (auto args = std::dynamic_pointer_cast<FuncArgs>(m_args)) {
+    Symbol get_param_type(size_t index) const {
+        if (auto args = dyn_cast<FuncArgs>(m_args)) {
             if (index < args->size()) {
                 auto arg = args->get_argument(index);
                 return arg->get_type(); 
             }
         }
-        return "";  
+        return {};
     }
 
+    /**
+     * @brief add_to_symtab_forward: Functions can be called before their definition. A name that
+     *        is taken already is left alone, checking the function reports it.
+     */
+    Node::Ptr add_to_symtab_forward(SymbolTable &st) override {
+        auto name = name_of(m_name);
+        if (! name.empty() && ! st.get_symbol(name)) {
+            st.add_symbol(name, this);
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief compute_stmt_type: Checks the signature, then the body in a scope of its own that
+     *        holds the parameters.
+     */
     Node::Ptr compute_stmt_type(SymbolTable &st) override {
-    set_cur_symtab(st.get_cur_symtab());
-    auto func_name = std::dynamic_pointer_cast<ast::Identifier>(m_name);
+        set_cur_symtab(st.get_cur_symtab());
+        auto func_name = dyn_cast<ast::Identifier>(m_name);
 
-    if (st.get_symbol(func_name->get_name())) {
-        return set_error(fmt::format("Function '{}' is already defined", func_name->get_name()));
-    }
+        // the module declares its functions ahead of time, see add_to_symtab_forward
+        if (auto entry = st.get_symbol(func_name->get_name()); entry && entry.stmt != this) {
+            return set_error(FF("Function '{}' is already defined", func_name->get_name()));
+        }
+        st.add_symbol(func_name->get_name(), this);
 
-    if (std::islower(func_name->get_name()[0])) {
-        return set_error(fmt::format("Function name '{}' can not start with a lowercase letter", func_name->get_name()));
-    }
+        auto return_type = name_of(m_returnType);
+        if (! st.get_type(return_type)) {
+            return set_error(FF("Return type '{}' of function '{}' is not found", return_type,
+                    func_name->get_name()));
+        }
 
-    st.add_symbol(func_name->get_name(), shared_from_this());
-    if (auto args = std::dynamic_pointer_cast<FuncArgs>(m_args)) {
-        std::unordered_set<std::string> seen_args;
+        auto scope_type = st.get_scope_type() == ScopeType::Class ? ScopeType::Method
+                                                                  : ScopeType::Func;
+        auto scope = st.enter_scope(scope_type, this);
+        if (auto args = dyn_cast<FuncArgs>(m_args)) {
+            for (const auto &arg : args->get_list()) {
+                auto arg_node = dyn_cast<ast::ArgNode>(arg);
+                if (! arg_node) {
+                    continue;
+                }
 
-        for (const auto &arg : args->get_list()) {
-            auto arg_node = std::dynamic_pointer_cast<ast::ArgNode>(arg);
-            if (!arg_node) {
-                continue;
-            }
+                auto arg_name = dyn_cast<ast::Identifier>(arg_node->get_name());
+                if (! arg_name) {
+                    return set_error(FF("Argument name is not valid in function '{}'",
+                            func_name->get_name()));
+                }
 
-            auto arg_name = std::dynamic_pointer_cast<ast::Identifier>(arg_node->get_name());
-            if (!arg_name) {
-                return set_error(fmt::format("Argument name is not valid in function '{}'", func_name->get_name()));
-            }
+                // names are not shadowed, so this also catches a repeated parameter
+                if (st.get_symbol(arg_name->get_name())) {
+                    return set_error(FF("Identifier '{}' in argument list of function '{}' is "
+                                        "already in symtab",
+                            arg_name->get_name(), func_name->get_name()));
+                }
 
-            if (seen_args.count(arg_name->get_name())) {
-                return set_error(fmt::format("Identifier '{}' in argument list of function '{}' is already in symtab", arg_name->get_name(), func_name->get_name()));
+                auto arg_type = st.get_type(arg_node->get_type());
+                if (! arg_type) {
+                    return set_error(FF("Identifier '{}' in type of argument '{}' in function '{}' "
+                                        "is not found",
+                            arg_node->get_type(), arg_name->get_name(), func_name->get_name()));
+                }
+
+                arg_node->set_cur_symtab(st.get_cur_symtab());
+                arg_node->set_stmt_type(arg_type);
+                st.add_symbol(arg_name->get_name(), arg_node);
             }
+        }
 
-            seen_args.insert(arg_name->get_name());
-            auto arg_type = arg_node->get_type();
-            if (auto type_name = std::dynamic_pointer_cast<ast::Identifier>(m_name)) {
-                if (!st.get_symbol(type_name->get_name())) {
-                    return set_error(fmt::format("Identifier '{}' in type of argument '{}' in function '{}' is not found", type_name->get_name(), arg_name->get_name(), func_name->get_name()));
-                }
-            } 
+        // the body can call the function itself, so the signature goes first
+        set_stmt_type(make_signature([&](Symbol name) { return st.get_type(name); }));
+        if (m_body) {
+            return m_body->compute_stmt_type(st);
         }
+        return nullptr;
     }
 
-    return shared_from_this();  
-}
+    /**
+     * @brief get_signature: The function type of this function as seen from the given symbol
+     *        table, for calls to it that are checked before the function is. nullptr if one of its
+     *        types does not resolve there.
+     */
+    const Type *get_signature(const SymbolTable &st) const {
+        if (auto type = get_stmt_type()) {
+            return type;
+        }
+        return make_signature([&](Symbol name) { return st.get_type(name); });
+    }
+
+    /**
+     * @brief get_signature: The function type of this function. Type checking records it; for
+     *        functions that were not checked it is made from the builtin type names.
+     * @throw std::runtime_error if a parameter or the result is not a builtin type.
+     */
+    const Type *get_signature() const {
+        if (auto type = get_stmt_type()) {
+            return type;
+        }
+        if (auto type = make_signature(Type::get_builtin)) {
+            return type;
+        }
+        throw std::runtime_error(
+                FF("Unsupported type in signature of function {}", name_of(m_name)));
+    }
+
+    /**
+     * @brief declare: Adds the signature of this function to the module, so that calls to it can
+     *        be emitted before its body.
+     */
+    uint32_t declare(wasm::ModuleBuilder &mb) const {
+        return mb.declare_function(name_of(m_name), get_signature());
+    }
 
-    Node::Ptr gen_wat(WasmContext &ctx) override {
-        std::string func_name = m_name->as_string();
-        std::string return_type = (m_returnType->as_string() == "Integer64") ? "i64" : "void";
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto index = mb.find_function(name_of(m_name));
+        if (! index) {
+            index = declare(mb);
+        }
+        mb.add_export(name_of(m_name).str(), wasm::ExternalKind::Func, *index);
 
-        std::string params;
-        if (auto args = std::dynamic_pointer_cast<FuncArgs>(m_args)) {
+        auto &func = mb.begin_function(*index);
+        if (auto args = dyn_cast<FuncArgs>(m_args)) {
             for (const auto &arg : args->get_list()) {
-                auto arg_node = std::dynamic_pointer_cast<ast::ArgNode>(arg);
-                if (arg_node) {
-                    params += fmt::format("(param ${} {}) ", 
-                                          arg_node->get_name()->as_string(),
-                                          (arg_node->get_type() == "Integer64") ? "i64" : "i32");
-                }
+                func.add_param(name_of(cast<ArgNode>(arg)->get_name()));
             }
         }
 
-        std::string body;
-        if (auto body_list = std::dynamic_pointer_cast<NodeList>(m_body)) {
-            for (const auto &stmt : body_list->get_list()) {
-                body += stmt->gen_wat(ctx)->as_string() + "\n";
+        gen_body(mb.get_share_locals(), [&](Symbol name) { func.locals().release(name); },
+                [&](const Node &stmt) {
+                    if (stmt.gen_wasm(mb)) {
+                        func.code().emit(wasm::Op::Drop);
+                    }
+                });
+
+        // falling off the end of a function that returns a value is an error
+        if (! func.get_type().results.empty()) {
+            func.code().emit(wasm::Op::Unreachable);
+        }
+
+        mb.end_function();
+        return nullptr;
+    }
+
+private:
+    /**
+     * @brief gen_body: Emits the statements of the body with the given callable. When locals are
+     *        shared, the lets are released with the other one as soon as they are dead.
+     */
+    template <typename Release, typename Gen>
+    void gen_body(bool share, Release &&release, Gen &&gen) const {
+        auto body = dyn_cast<NodeList>(m_body);
+        if (! body) {
+            return;
+        }
+
+        const auto &stmts = body->get_list();
+        auto deaths = share ? opt::dead_lets(*body) : std::vector<opt::Deaths>(stmts.size());
+        for (size_t i = 0; i < stmts.size(); ++i) {
+            for (auto name : deaths[i].before) {
+                release(name);
+            }
+            gen(*stmts[i]);
+            for (auto name : deaths[i].after) {
+                release(name);
             }
         }
+    }
 
-        std::string wat_code = fmt::format("(func ${} {} (result {})\n{})",
-                                           func_name, params, return_type, body);
+    /**
+     * @brief make_signature: The function type made of the parameter and result types as resolved
+     *        by the given callable, nullptr if one of them does not resolve.
+     */
+    template <typename Resolve>
+    const Type *make_signature(Resolve &&resolve) const {
+        std::vector<const Type *> params;
+        if (auto args = dyn_cast<FuncArgs>(m_args)) {
+            for (const auto &arg : args->get_list()) {
+                auto type = resolve(arg->get_type());
+                if (! type) {
+                    return nullptr;
+                }
+                params.push_back(type);
+            }
+        }
 
-        ctx.body() << wat_code << "\n";
-        return shared_from_this();
+        auto result = resolve(name_of(m_returnType));
+        if (! result) {
+            return nullptr;
+        }
+        return Compiler::current()->get_types().get_func(params, result);
     }
 
-private:
     Node::Ptr m_name;        
     Node::Ptr m_args;         
     Node::Ptr m_returnType;   
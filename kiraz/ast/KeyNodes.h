@@ -12,15 +12,30 @@ namespace ast {
 
 class IfNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::IfNode; }
+
     IfNode(Node::Ptr condition, Node::Ptr thenBranch, Node::Ptr elseBranch)
-        : Node(KW_IF), m_condition(condition), m_thenBranch(thenBranch), m_elseBranch(elseBranch) {}
-
-    std::string as_string() const override {
-        std::string result = fmt::format("If(?={}, then={}, else={})", 
-                                          m_condition ? m_condition->as_string() : "null",
-                                          m_thenBranch ? m_thenBranch->as_string() : "[]",
-                                          m_elseBranch ? m_elseBranch->as_string() : "[]");
-        return result;
+        : Node(NodeKind::IfNode, KW_IF), m_condition(condition), m_thenBranch(thenBranch), m_elseBranch(elseBranch) {}
+
+    void dump(Dumper &out) const {
+        out << "If(?=";
+        m_condition ? out << m_condition : out << "null";
+        out << ", then=";
+        m_thenBranch ? out << m_thenBranch : out << "[]";
+        out << ", else=";
+        m_elseBranch ? out << m_elseBranch : out << "[]";
+        out << ")";
+    }
+
+    Node::Ptr get_condition() const { return m_condition; }
+    Node::Ptr get_then() const { return m_thenBranch; }
+    Node::Ptr get_else() const { return m_elseBranch; }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_condition);
+        fn(m_thenBranch);
+        fn(m_elseBranch);
     }
 
     Node::Ptr compute_stmt_type(SymbolTable &st) override {
@@ -30,15 +45,7 @@ public:
         return ret; 
     }
 
-    if (auto condition = std::dynamic_pointer_cast<ast::Integer>(m_condition)) {
-        return set_error("If only accepts tests of type 'Boolean'");
-    }
-
-    if (auto condition = std::dynamic_pointer_cast<ast::StringLiteral>(m_condition)) {
-        return set_error("If only accepts tests of type 'Boolean'");
-    }
-
-    if (auto condition = std::dynamic_pointer_cast<ast::Identifier>(m_condition)) {
+    if (auto type = m_condition->get_stmt_type(); type && type != &Type::Boolean) {
         return set_error("If only accepts tests of type 'Boolean'");
     }
 
@@ -69,13 +76,26 @@ private:
 
 class WhileNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::WhileNode; }
+
     WhileNode(Node::Ptr condition, Node::Ptr repeat)
-        : Node(KW_WHILE), m_condition(condition), m_repeat(repeat) {}
+        : Node(NodeKind::WhileNode, KW_WHILE), m_condition(condition), m_repeat(repeat) {}
+
+    void dump(Dumper &out) const {
+        out << "While(?=";
+        m_condition ? out << m_condition : out << "null";
+        out << ", repeat=";
+        m_repeat ? out << m_repeat : out << "[]";
+        out << ")";
+    }
 
-    std::string as_string() const override {
-        return fmt::format("While(?={}, repeat={})", 
-                           m_condition ? m_condition->as_string() : "null",
-                           m_repeat ? m_repeat->as_string() : "[]");
+    Node::Ptr get_condition() const { return m_condition; }
+    Node::Ptr get_repeat() const { return m_repeat; }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_condition);
+        fn(m_repeat);
     }
 
     Node::Ptr compute_stmt_type(SymbolTable &st) override {
@@ -83,6 +103,10 @@ public:
         return ret; 
     }
 
+    if (auto type = m_condition->get_stmt_type(); type && type != &Type::Boolean) {
+        return set_error("While only accepts tests of type 'Boolean'");
+    }
+
     if (ScopeType::Module == st.get_scope_type()){
         return set_error("Misplaced while statement");
     } 
@@ -102,19 +126,34 @@ private:
 
 class ImportNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::ImportNode; }
+
     ImportNode(Node::Ptr name)
-        : Node(KW_IMPORT), m_name(name) {}
+        : Node(NodeKind::ImportNode, KW_IMPORT), m_name(name) {}
 
-    std::string as_string() const override {
-        return fmt::format("Import({})", m_name ? m_name->as_string() : "null");
+    void dump(Dumper &out) const {
+        out << "Import(";
+        m_name ? out << m_name : out << "null";
+        out << ")";
     }
 
 
+    /**
+     * @brief compute_stmt_type: Brings the named module into scope under its own name.
+     */
     Node::Ptr compute_stmt_type(SymbolTable &st) override {
-    if (!st.get_symbol(m_name->as_string())) {
-        return set_error(fmt::format("Identifier '{}' is not found", m_name->as_string()));
-    }
-    return nullptr; 
+        set_cur_symtab(st.get_cur_symtab());
+        auto name = name_of(m_name);
+        auto module = Compiler::current()->get_module(name);
+        if (! module) {
+            return set_error(FF("Module '{}' is not found", name));
+        }
+        if (st.get_symbol(name)) {
+            return set_error(FF("Identifier '{}' is already in symtab", name));
+        }
+
+        st.add_symbol(name, module);
+        return nullptr;
     }
     
 
@@ -124,11 +163,19 @@ private:
 
 class CallNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::CallNode; }
+
     CallNode(Node::Ptr name, Node::Ptr args)
-        : Node(-1), m_name(name), m_args(args) {}
+        : Node(NodeKind::CallNode, -1), m_name(name), m_args(args) {}
+
+    void dump(Dumper &out) const { out << "Call(n=" << m_name << ", a=" << m_args << ")"; }
+
+    Node::Ptr get_name() const { return m_name; }
+    Node::Ptr get_arg_list() const { return m_args; }
 
-    std::string as_string() const override {
-        return fmt::format("Call(n={}, a={})", m_name->as_string(), m_args->as_string());
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_args);
     }
 
     Node::Ptr compute_stmt_type(SymbolTable &st) override {
@@ -138,90 +185,190 @@ public:
             return ret;
         }
 
-        auto funcIdentifier = std::dynamic_pointer_cast<ast::Identifier>(m_name);
-        if (!funcIdentifier) {
-            return set_error("Function name is not a valid identifier.");
+        const auto &givenArgs = cast<FuncArgs>(m_args)->get_list();
+        auto funcIdentifier = dyn_cast<ast::Identifier>(m_name);
+        if (! funcIdentifier) {
+            // members of modules and classes are not resolved yet, only the arguments are checked
+            for (const auto &arg : givenArgs) {
+                if (auto ret = arg->compute_stmt_type(st)) {
+                    return ret;
+                }
+            }
+            return nullptr;
         }
 
-        auto curScope = st.get_cur_symtab(); 
-        
-        auto funcSymbol = curScope->find(funcIdentifier->get_name());
-        if (funcSymbol == curScope->end()) {
-            return set_error(fmt::format("Identifier '{}' is not found", funcIdentifier->get_name()));
+        // and, or and not are builtin functions over Booleans
+        if (st.is_builtin_keyword(funcIdentifier->get_name())) {
+            size_t arity = funcIdentifier->get_name() == sym::Not ? 1 : 2;
+            if (givenArgs.size() != arity) {
+                return set_error(FF("Call to function '{}' has wrong number of arguments",
+                        funcIdentifier->get_name()));
+            }
+
+            for (size_t i = 0; i < arity; ++i) {
+                if (auto ret = givenArgs[i]->compute_stmt_type(st)) {
+                    return ret;
+                }
+
+                auto argType = givenArgs[i]->get_stmt_type();
+                if (argType && argType != &Type::Boolean) {
+                    return set_error(FF("Argument {} in call to function '{}' has type '{}' "
+                                        "which does not match definition type 'Boolean'",
+                            i + 1, funcIdentifier->get_name(), *argType));
+                }
+            }
+
+            set_stmt_type(&Type::Boolean);
+            return nullptr;
+        }
+
+        auto funcSymbol = st.get_symbol(funcIdentifier->get_name());
+        if (! funcSymbol) {
+            return set_error(FF("Identifier '{}' is not found", funcIdentifier->get_name()));
+        }
+
+        auto funcNode = dyn_cast<ast::FuncNode>(funcSymbol.stmt);
+        if (! funcNode) {
+            return set_error(FF("Identifier '{}' is not a function", funcIdentifier->get_name()));
         }
 
-        auto funcNode = std::dynamic_pointer_cast<ast::FuncNode>(funcSymbol->second);
         auto paramCount = funcNode->get_param_count();
-        auto givenArgs = m_args->get_args(); 
         if (paramCount != givenArgs.size()) {
-            return set_error(fmt::format("Call to function '{}' has wrong number of arguments", funcIdentifier->get_name()));
+            return set_error(FF("Call to function '{}' has wrong number of arguments",
+                    funcIdentifier->get_name()));
         }
 
+        // the function may be defined further down and not be checked yet
+        auto funcType = funcNode->get_signature(st);
         for (size_t i = 0; i < paramCount; ++i) {
-            auto paramType = funcNode->get_param_type(i);
-            auto argType = givenArgs[i]->get_type();
-            if (paramType != argType) {
-                return set_error(fmt::format("Argument {} in call to function '{}' has type '{}' which does not match definition type '{}'",
-                                             i + 1, funcIdentifier->get_name(), argType, paramType));
+            if (auto ret = givenArgs[i]->compute_stmt_type(st)) {
+                return ret;
+            }
+
+            auto argType = givenArgs[i]->get_stmt_type();
+            if (funcType && argType && ! argType->converts_to(funcType->get_params()[i])) {
+                return set_error(FF("Argument {} in call to function '{}' has type '{}' which "
+                                    "does not match definition type '{}'",
+                        i + 1, funcIdentifier->get_name(), *argType, *funcType->get_params()[i]));
             }
         }
 
+        if (funcType) {
+            set_stmt_type(funcType->get_result());
+        }
         return nullptr;
     }
 
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto index = mb.find_function(name_of(m_name));
+        if (! index) {
+            throw std::runtime_error(FF("Function {} is not found", m_name->as_string()));
+        }
+
+        auto type = mb.get_function_decl(*index);
+        if (! type) {
+            throw std::runtime_error(FF("Function {} is not defined in this module",
+                    m_name->as_string()));
+        }
+
+        const auto &args = cast<FuncArgs>(m_args)->get_list();
+        if (args.size() != type->get_params().size()) {
+            throw std::runtime_error(FF("Wrong number of arguments in {}", as_string()));
+        }
+
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i]->gen_wasm(mb) != type->get_params()[i]) {
+                throw std::runtime_error(FF("Argument {} has the wrong type in {}", i + 1,
+                        as_string()));
+            }
+        }
+
+        mb.current().code().emit(wasm::Op::Call, *index, name_of(m_name));
+        return value_of(type->get_result());
+    }
+
 private:
+    // Void calls leave nothing on the stack
+    static const Type *value_of(const Type *result) {
+        return result == &Type::Void ? nullptr : result;
+    }
+
     Node::Ptr m_name;  
     Node::Ptr m_args;
 };
 
 class ClassNode : public Node {
 public:
-    ClassNode(Node::Ptr name, Node::Ptr stmt_list, Node::Cptr parent = nullptr)
-        : Node(KW_CLASS), m_name(name), m_stmt_list(stmt_list), m_parent(parent) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::ClassNode; }
 
-    std::string as_string() const override {
-        std::string name_str = m_name ? m_name->as_string() : "null";
-        std::string stmt_list_str = m_stmt_list ? m_stmt_list->as_string() : "[]";
-        return fmt::format("Class(n={}, s={})", name_str, stmt_list_str);
+    ClassNode(Node::Ptr name, Node::Ptr stmt_list, Node::Cptr parent = nullptr)
+        : Node(NodeKind::ClassNode, KW_CLASS), m_name(name), m_stmt_list(stmt_list), m_parent(parent) {}
+
+    void dump(Dumper &out) const {
+        out << "Class(n=";
+        m_name ? out << m_name : out << "null";
+        out << ", s=";
+        m_stmt_list ? out << m_stmt_list : out << "[]";
+        out << ")";
     }
 
-    Node::Ptr compute_stmt_type(SymbolTable &st) override {
-        set_cur_symtab(st.get_cur_symtab());
-        std::shared_ptr<const ast::Identifier> class_name;
+    Node::Ptr get_name() const { return m_name; }
+    Node::Ptr get_stmt_list() const { return m_stmt_list; }
+    Node::Cptr get_parent_class() const { return m_parent; }
 
-        if (auto temp_name = std::dynamic_pointer_cast<const ast::Identifier>(m_name)) {
-            class_name = temp_name;
-            } else {
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_stmt_list);
+    }
 
-        return nullptr;
+    /**
+     * @brief add_to_symtab_forward: Classes can be used before their definition. A name that is
+     *        taken already is left alone, checking the class reports it.
+     */
+    Node::Ptr add_to_symtab_forward(SymbolTable &st) override {
+        auto name = name_of(m_name);
+        if (! name.empty() && ! st.get_symbol(name)) {
+            st.add_symbol(name, this);
         }
-        if (std::islower(class_name->get_name()[0])) {
-        return set_error(fmt::format("Class name '{}' can not start with a lowercase letter", class_name->get_name()));
-    } else {
-              st.add_symbol(class_name->get_name(), shared_from_this());
+        return nullptr;
     }
 
-      if (auto class_name = std::dynamic_pointer_cast<const ast::Identifier>(m_name)) {
-            if (st.get_symbol(class_name->get_name())) {
-                return set_error(fmt::format("Identifier '{}' is already in symtab", class_name->get_name()));
-            } else {
-              st.add_symbol(class_name->get_name(), shared_from_this());
-    }
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        auto class_name = dyn_cast<ast::Identifier>(m_name);
+        if (! class_name) {
+            return nullptr;
         }
 
+        if (std::islower(class_name->get_name().str()[0])) {
+            return set_error(fmt::format("Class name '{}' can not start with a lowercase letter",
+                    class_name->get_name()));
+        }
+        // the module declares its classes ahead of time, see add_to_symtab_forward
+        if (auto entry = st.get_symbol(class_name->get_name()); entry && entry.stmt != this) {
+            return set_error(
+                    fmt::format("Identifier '{}' is already in symtab", class_name->get_name()));
+        }
 
-      st.add_symbol(class_name->get_name(), shared_from_this());
+        st.add_symbol(class_name->get_name(), this);
+        auto type = st.get_types().get_class(class_name->get_name(), this);
+        set_stmt_type(type);
 
         if (m_parent) {
-            if (auto parent_class_name = std::dynamic_pointer_cast<const ast::Identifier>(m_parent)) {
-                if (!st.get_symbol(parent_class_name->get_name())) {
-                    return set_error(fmt::format("Type '{}' is not found", parent_class_name->get_name()));
-                }
-            } 
+            auto parent_name = name_of(m_parent);
+            auto base = st.get_type(parent_name);
+            if (! base || base->get_kind() != Type::Kind::Class) {
+                return set_error(fmt::format("Type '{}' is not found", parent_name));
+            }
+            if (base->converts_to(type)) {
+                return set_error(fmt::format("Class '{}' can not derive from itself",
+                        class_name->get_name()));
+            }
+            st.get_types().set_base(type, base);
         }
 
        if (m_stmt_list) {
-        if (auto stmt_list_identifier = std::dynamic_pointer_cast<const ast::Identifier>(m_stmt_list)) {
+        if (auto stmt_list_identifier = dyn_cast<ast::Identifier>(m_stmt_list)) {
             if (!st.get_symbol(stmt_list_identifier->get_name())) {
                 return set_error(fmt::format("Identifier '{}.{}' is not found", class_name->get_name(), stmt_list_identifier->get_name()));
             }
@@ -245,20 +392,21 @@ private:
 
 class Combined : public Node {
 public:
-    Combined() : Node(-2) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::Combined; }
+
+    Combined() : Node(NodeKind::Combined, -2) {}
 
     void add_node(Node::Ptr node) {
         m_nodes.push_back(node);
     }
 
-    std::string as_string() const override {
-        std::string result = "";
-        for (size_t i = 0; i < m_nodes.size(); ++i) {
-            result += m_nodes[i]->as_string();
-            if (i < m_nodes.size() - 1) result += ", ";
+    void dump(Dumper &out) const { out.list(m_nodes); }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        for (auto &node : m_nodes) {
+            fn(node);
         }
-        result += "";
-        return result;
     }
 
 private:
@@ -267,37 +415,69 @@ private:
 
 class ReturnNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::ReturnNode; }
+
     explicit ReturnNode(Node::Ptr value)
-        : Node(KW_RETURN), m_value(value) {}
+        : Node(NodeKind::ReturnNode, KW_RETURN), m_value(value) {}
 
-    std::string as_string() const override {
-        return fmt::format("Return({})", m_value ? m_value->as_string() : "null");
+    void dump(Dumper &out) const {
+        out << "Return(";
+        m_value ? out << m_value : out << "null";
+        out << ")";
     }
 
-     Node::Ptr compute_stmt_type(SymbolTable &st) override {
-        auto parent = dynamic_cast<ast::FuncNode*>(get_parent());
-        if (!parent) {
-            return set_error("Misplaced return statement");  
+    Node::Ptr get_value() const { return m_value; }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_value);
+    }
+
+    /**
+     * @brief compute_stmt_type: The value has to be of the result type of the function the return
+     *        is in, which is the one whose scope is being checked.
+     */
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        auto func = dyn_cast<ast::FuncNode>(st.get_func());
+        if (! func) {
+            return set_error("Misplaced return statement");
         }
-        
-        auto func_name = parent->get_name();  
-        auto return_type = parent->get_return_type();  
 
-        if (!return_type) {
-            return set_error(fmt::format("Return type '{}' of function '{}' is not found", return_type->as_string(), func_name->as_string()));
+        // the function records its signature before its body is checked
+        auto signature = func->get_stmt_type();
+        if (! signature) {
+            return set_error(FF("Return type '{}' of function '{}' is not found",
+                    name_of(func->get_return_type()), name_of(func->get_name())));
         }
 
         if (m_value) {
-            auto value_type = m_value->compute_stmt_type(st);
-            if (value_type && value_type != return_type) {
-                return set_error(fmt::format("Return statement type '{}' does not match function return type '{}'",
-                                             value_type->as_string(), return_type->as_string()));
+            if (auto ret = m_value->compute_stmt_type(st)) {
+                return ret;
+            }
+
+            auto value_type = m_value->get_stmt_type();
+            auto expected = signature->get_result();
+            if (value_type && ! value_type->converts_to(expected)) {
+                return set_error(FF("Return statement type '{}' does not match function return "
+                                    "type '{}'",
+                        *value_type, *expected));
             }
         }
 
-        return nullptr;  
+        return nullptr;
     }
 
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto &func = mb.current();
+        auto type = m_value ? m_value->gen_wasm(mb) : nullptr;
+        if ((type ? type : &Type::Void) != func.get_result()) {
+            throw std::runtime_error(FF("Return type mismatch in {}", as_string()));
+        }
+
+        func.code().emit(wasm::Op::Return);
+        return nullptr;
+    }
 
 private:
     Node::Ptr m_value;
@@ -305,11 +485,17 @@ private:
 
 class DotNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::DotNode; }
+
     DotNode(Node::Ptr left, Node::Ptr right)
-        : Node(OP_DOT), m_left(left), m_right(right) {}
+        : Node(NodeKind::DotNode, OP_DOT), m_left(left), m_right(right) {}
+
+    void dump(Dumper &out) const { out << "Dot(l=" << m_left << ", r=" << m_right << ")"; }
 
-    std::string as_string() const override {
-        return fmt::format("Dot(l={}, r={})", m_left->as_string(), m_right->as_string());
+    // the member is a name, only the object is evaluated
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_left);
     }
 
 private:
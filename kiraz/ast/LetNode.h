@@ -10,102 +10,126 @@ namespace ast {
 
 class LetNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::LetNode; }
+
     LetNode(Node::Ptr name, Node::Ptr type = nullptr, Node::Ptr initializer = nullptr)
-        : Node(KW_LET), m_name(name), m_type(type), m_initializer(initializer) {}
+        : Node(NodeKind::LetNode, KW_LET), m_name(name), m_type(type), m_initializer(initializer) {}
 
-    std::string as_string() const override {
-        std::string result = fmt::format("Let(n={}", m_name->as_string());
+    void dump(Dumper &out) const {
+        out << "Let(n=" << m_name;
 
         if (m_type) {
-            result += fmt::format(", t={}", m_type->as_string());
+            out << ", t=" << m_type;
         }
         
         if (m_initializer) {
-            result += fmt::format(", i={}", m_initializer->as_string());
+            out << ", i=" << m_initializer;
         }
 
-        result += ")";
-        return result;
+        out << ")";
+    }
+
+    Symbol get_name() const {
+        return name_of(m_name);
     }
 
-    std::string get_name() const {
-        return m_name->as_string();
+    Node::Ptr get_type_name() const { return m_type; }
+    Node::Ptr get_initializer() const { return m_initializer; }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_initializer);
     }
 
     Node::Ptr compute_stmt_type(SymbolTable &st) override {
         set_cur_symtab(st.get_cur_symtab());
 
-        if (auto var_name = std::dynamic_pointer_cast<const ast::LetNode>(m_name)) {
-            if (st.get_symbol(var_name->get_name())) {
-            
-            return set_error(fmt::format("Identifier '{}' is already in symtab", var_name->get_name()));
-            }  else {
-                st.add_symbol(var_name->get_name(), shared_from_this());
-            }
-        if (isupper(var_name->get_name()[0])) {
-                return set_error(fmt::format("Variable name '{}' can not start with an uppercase letter", var_name->get_name()));
-            } else {
-                st.add_symbol(var_name->get_name(), shared_from_this());
-            }
-
+        auto name = get_name();
+        if (st.get_symbol(name)) {
+            return set_error(fmt::format("Identifier '{}' is already in symtab", name));
+        }
+        if (std::isupper(name.str().front())) {
+            return set_error(
+                    fmt::format("Variable name '{}' can not start with an uppercase letter", name));
         }
 
+        const Type *declared = nullptr;
         if (m_type) {
-            if (auto type_name = std::dynamic_pointer_cast<const ast::LetNode>(m_type)) {
-                if (!st.get_symbol(type_name->get_name())) {
-                    return set_error(fmt::format("Type '{}' not found", type_name->get_name()));
-                }
-            } else {
+            auto type_name = name_of(m_type);
+            if (type_name.empty()) {
                 return set_error("LetNode type must be an identifier");
             }
+
+            declared = st.get_type(type_name);
+            if (! declared) {
+                return set_error(fmt::format("Type '{}' not found", type_name));
+            }
         }
 
+        const Type *type = declared;
         if (m_initializer) {
-                if (auto while_node = std::dynamic_pointer_cast<const ast::WhileNode>(m_initializer)) {
-                    return nullptr;
-                }
-                
-                else if (auto if_node = std::dynamic_pointer_cast<const ast::IfNode>(m_initializer)) {
-                    return nullptr;
-                }
-                else {
-                if (auto initializer_type = m_initializer->compute_stmt_type(st)) {
-                if (m_type) {
-                    if (auto type_name = std::dynamic_pointer_cast<const ast::Identifier>(m_type)) {
-                        if (initializer_type->as_string() != type_name->as_string()) {
-                            return set_error(fmt::format("Initializer type '{}' doesn't match explicit type '{}'", 
-                            initializer_type->as_string(), type_name->as_string()));
-                        }
-                    }
-                }
+            if (auto ret = m_initializer->compute_stmt_type(st)) {
+                return ret;
+            }
+
+            auto init_type = m_initializer->get_stmt_type();
+            if (declared && init_type && ! init_type->converts_to(declared)) {
+                return set_error(
+                        fmt::format("Initializer type '{}' does not match explicit type '{}'",
+                                    *init_type, *declared));
+            }
+            if (! type) {
+                type = init_type;
             }
         }
-    } 
 
-        return shared_from_this(); 
+        if (type) {
+            set_stmt_type(type);
+        }
+        st.add_symbol(name, this);
+        return nullptr;
     }
 
-    Node::Ptr gen_wat(WasmContext &ctx) override {
-        std::string wat_code;
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto &func = mb.current();
 
-        if (m_type->as_string() == "Integer64") {
-            ctx.locals() << fmt::format("  (local ${} i64)\n", get_name());
-        } else if (m_type->as_string() == "Integer32") {
-            ctx.locals() << fmt::format("  (local ${} i32)\n", get_name());
-        } else {
-            throw std::runtime_error(fmt::format("Unsupported type '{}'", m_type->as_string()));
+        // the initializer is emitted first, it can not refer to the new local
+        auto type = m_initializer ? m_initializer->gen_wasm(mb) : nullptr;
+        if (m_type) {
+            auto declared = get_declared_type();
+            if (m_initializer && type != declared) {
+                throw std::runtime_error(FF("Initializer type mismatch in {}", as_string()));
+            }
+            type = declared;
         }
 
-        if (m_initializer) {
-            auto initializer_wat = m_initializer->gen_wat(ctx)->as_string();
-            wat_code += fmt::format("{}\n  local.set ${}", initializer_wat, get_name());
+        if (! type || ! wasm::type_of(type)) {
+            throw std::runtime_error(FF("Variable {} can not be Void", get_name()));
         }
 
-        ctx.body() << wat_code << "\n";
-        return shared_from_this();
+        // a local that is stored to right away can take the slot of a dead one
+        auto index = func.locals().add_local(get_name(), type, m_initializer != nullptr);
+        if (m_initializer) {
+            func.emit_local(wasm::Op::LocalSet, index);
+        }
+        return nullptr;
     }
 
 private:
+    /**
+     * @brief get_declared_type: The explicit type, as recorded by type checking or else looked up
+     *        among the builtin types.
+     */
+    const Type *get_declared_type() const {
+        if (auto type = get_stmt_type()) {
+            return type;
+        }
+        if (auto type = Type::get_builtin(name_of(m_type))) {
+            return type;
+        }
+        throw std::runtime_error(FF("Unsupported type '{}'", name_of(m_type)));
+    }
+
     Node::Ptr m_name;          
     Node::Ptr m_type;          
     Node::Ptr m_initializer;   
@@ -2,32 +2,30 @@
 #include "Literal.h"
 
 #include <cassert>
+#include <charconv>
 #include <kiraz/token/Literal.h>
 
 namespace ast {
-    Integer::Integer(Token::Ptr t) : Node(L_INTEGER){
-        assert(t->get_id() == L_INTEGER);
-        auto token_int = std::static_pointer_cast<const token::Integer>(t);
-        auto base = token_int->get_base();
+    Integer::Integer(const Token &t) : Node(NodeKind::Integer, L_INTEGER){
+        assert(t.get_id() == L_INTEGER);
+        auto token_int = token::Integer(t);
+        auto value = token_int.get_value();
 
-        try{
-            m_value = std::stoll(token_int->get_value(), nullptr, base);
-        }
-        catch (const std::exception& e){
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), m_value,
+                token_int.get_base());
+        if (ec != std::errc()) {
             //TODO Mark this node as invalid
         }
     }
 
-    Identifier::Identifier(Token::Ptr t) : Node(IDENTIFIER) {
-        assert(t->get_id() == IDENTIFIER);
-        auto token_id = std::static_pointer_cast<const token::Identifier>(t);
-        m_name = token_id->get_name();
+    Identifier::Identifier(const Token &t) : Node(NodeKind::Identifier, IDENTIFIER) {
+        assert(t.get_id() == IDENTIFIER);
+        m_name = token::Identifier(t).get_symbol();
     }
 
-    StringLiteral::StringLiteral(Token::Ptr token) : Node(L_STRING) {
-        assert(token->get_id() == L_STRING); 
-        auto token_str = std::static_pointer_cast<const token::StringLiteral>(token);
-        m_value = token_str->get_value();
+    StringLiteral::StringLiteral(const Token &token) : Node(NodeKind::StringLiteral, L_STRING) {
+        assert(token.get_id() == L_STRING); 
+        m_value = token::StringLiteral(token).get_value();
     }
 
 }
@@ -1,55 +1,159 @@
 #ifndef KIRAZ_AST_LITERAL_H
 #define KIRAZ_AST_LITERAL_H
 
+#include <kiraz/Compiler.h>
 #include <kiraz/Node.h>
+#include <kiraz/ast/Dump.h>
+#include <kiraz/wasm/Binary.h>
 
 namespace ast {
 class Integer : public Node {
 public:
-    Integer(Token::Ptr);
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::Integer; }
 
-    std::string as_string() const override {return fmt::format("Int({})", m_value); }
+    Integer(const Token &);
+    explicit Integer(int64_t value) : Node(NodeKind::Integer, L_INTEGER), m_value(value) {}
+
+    void dump(Dumper &out) const { out << "Int(" << m_value << ")"; }
+
+    int64_t get_value() const { return m_value; }
+
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        set_stmt_type(&Type::Integer64);
+        return nullptr;
+    }
+
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        mb.current().code().emit(wasm::Op::I64Const, m_value);
+        return &Type::Integer64;
+    }
 
 private:
-    int64_t m_value;
+    int64_t m_value = 0;
 };
 
 class SignedNode : public Node {
 public:
-    SignedNode(int op, Node::Cptr operand) : Node(L_INTEGER), m_operator(op), m_operand(operand) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::SignedNode; }
+
+    SignedNode(int op, Node::Ptr operand) : Node(NodeKind::SignedNode, L_INTEGER), m_operator(op), m_operand(operand) {}
+
+    void dump(Dumper &out) const {
+        out << "Signed(" << (m_operator == OP_MINUS ? "OP_MINUS" : "OP_PLUS") << ", " << m_operand
+            << ")";
+    }
+
+    int get_operator() const { return m_operator; }
+    Node::Ptr get_operand() const { return m_operand; }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_operand);
+    }
+
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        set_stmt_type(&Type::Integer64);
+        return nullptr;
+    }
 
-    std::string as_string() const override {
-        std::string op_str = (m_operator == OP_MINUS) ? "OP_MINUS" : "OP_PLUS";
-        return fmt::format("Signed({}, {})", op_str, m_operand->as_string());
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto &code = mb.current().code();
+        if (m_operator == OP_MINUS) {
+            code.emit(wasm::Op::I64Const, 0);
+        }
+
+        if (m_operand->gen_wasm(mb) != &Type::Integer64) {
+            throw std::runtime_error(FF("Operand of {} is not an Integer64", as_string()));
+        }
+
+        if (m_operator == OP_MINUS) {
+            code.emit(wasm::Op::I64Sub);
+        }
+        return &Type::Integer64;
     }
 
 private:
     int m_operator;
-    Node::Cptr m_operand;
+    Node::Ptr m_operand;
 };
 
 class Identifier : public Node {
 public:
-    Identifier(Token::Ptr token);
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::Identifier; }
 
-    std::string as_string() const override { return fmt::format("Id({})", m_name); }
+    Identifier(const Token &token);
+    Identifier(Symbol name) : Node(NodeKind::Identifier, IDENTIFIER), m_name(name) {}
 
+    void dump(Dumper &out) const { out << "Id(" << m_name.str() << ")"; }
 
-    std::string get_name() const {
+
+    Symbol get_name() const {
         return m_name;  
     }
 
+    bool is_boolean() const { return m_name == sym::True || m_name == sym::False; }
+
+    /**
+     * @brief compute_stmt_type: The type of a name is the type of what it refers to, if that is
+     *        known by the time the name is checked.
+     */
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        if (is_boolean()) {
+            set_stmt_type(&Type::Boolean);
+        }
+        else if (auto entry = st.get_symbol(m_name); entry && entry.stmt->get_stmt_type()) {
+            set_stmt_type(entry.stmt->get_stmt_type());
+        }
+        return nullptr;
+    }
+
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto &func = mb.current();
+        if (is_boolean()) {
+            func.code().emit(wasm::Op::I32Const, m_name == sym::True);
+            return &Type::Boolean;
+        }
+
+        auto index = func.locals().find(m_name);
+        if (! index) {
+            throw std::runtime_error(FF("Identifier '{}' is not a local", m_name));
+        }
+
+        func.emit_local(wasm::Op::LocalGet, *index);
+        return func.locals().get_type(*index);
+    }
+
 
 private:
-    std::string m_name;
+    Symbol m_name;
 };
 
+/**
+ * @brief name_of: Returns the name held by the given node if it is an identifier, otherwise the
+ *        empty symbol.
+ */
+inline Symbol name_of(const Node::Cptr &node) {
+    if (auto id = dyn_cast<Identifier>(node)) {
+        return id->get_name();
+    }
+    return {};
+}
+
 class StringLiteral : public Node {
 public:
-    StringLiteral(Token::Ptr token);
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::StringLiteral; }
+
+    StringLiteral(const Token &token);
+
+    void dump(Dumper &out) const { out << "Str(" << m_value << ")"; }
 
-    std::string as_string() const override { 
-        return fmt::format("Str({})", m_value); 
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        set_stmt_type(&Type::String);
+        return nullptr;
     }
 
 private:
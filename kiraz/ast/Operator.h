@@ -10,21 +10,32 @@
 namespace ast {
 class OpBinary : public Node {
     protected:
-        explicit OpBinary(int op, const Node::Ptr &left, const Node::Ptr &right)
-            : Node(op), m_left(left), m_right(right){
+        explicit OpBinary(NodeKind kind, int op, const Node::Ptr &left, const Node::Ptr &right)
+            : Node(kind, op), m_left(left), m_right(right){
                 assert(left);
                 assert(right);
             }
 
     public:
+        static bool classof(const Node *node) {
+            return node->get_kind() >= NodeKind::FirstOpBinary
+                    && node->get_kind() <= NodeKind::LastOpBinary;
+        }
+
         auto get_left() const {return m_left; }
         auto get_right() const {return m_right; }
 
-        std::string as_string() const override {
+        template <typename Fn>
+        void for_each_child(Fn &&fn) {
+            fn(m_left);
+            fn(m_right);
+        }
+
+        void dump(Dumper &out) const {
             assert(get_left());
             assert(get_right());
 
-            std::string opstr;
+            std::string_view opstr;
                 switch(get_id()) {
                     case OP_PLUS:
                         opstr = "Add";
@@ -57,106 +68,186 @@ class OpBinary : public Node {
                         break;
                 }
 
-                return fmt::format("{}(l={}, r={})", opstr, get_left()->as_string(), get_right()->as_string());
+                out << opstr << "(l=" << get_left() << ", r=" << get_right() << ")";
         }
-        Node::Ptr check_type(SymbolTable &st) {
-            auto left_type = m_left->compute_stmt_type(st);
-            auto right_type = m_right->compute_stmt_type(st);
+        Node::Ptr compute_stmt_type(SymbolTable &st) override {
+            set_cur_symtab(st.get_cur_symtab());
+            if (auto ret = m_left->compute_stmt_type(st)) {
+                return ret;
+            }
+            if (auto ret = m_right->compute_stmt_type(st)) {
+                return ret;
+            }
+
+            auto left_type = m_left->get_stmt_type();
+            auto right_type = m_right->get_stmt_type();
+            if (! left_type || ! right_type) {
+                return nullptr;
+            }
 
             if (get_id() == OP_PLUS) {
                 if (left_type != right_type) {
-                    return set_error(fmt::format("Operator '+' not defined for types '{}' and '{}'", 
-                                                 left_type->as_string(), right_type->as_string()));
+                    return set_error(fmt::format("Operator '+' not defined for types '{}' and '{}'",
+                                                 *left_type, *right_type));
                 }
             }
 
+            set_stmt_type(is_comparison() ? &Type::Boolean : left_type);
             return nullptr;
         }
 
+        bool is_comparison() const {
+            switch (get_id()) {
+            case OP_EQ:
+            case OP_GT:
+            case OP_GE:
+            case OP_LT:
+            case OP_LE:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+            auto left = get_left()->gen_wasm(mb);
+            auto right = get_right()->gen_wasm(mb);
+            if (left != &Type::Integer64 || right != &Type::Integer64) {
+                throw std::runtime_error(FF("Operands of {} are not Integer64", as_string()));
+            }
+
+            auto &code = mb.current().code();
+            switch (get_id()) {
+            case OP_PLUS:
+                code.emit(wasm::Op::I64Add);
+                return &Type::Integer64;
+            case OP_MINUS:
+                code.emit(wasm::Op::I64Sub);
+                return &Type::Integer64;
+            case OP_MULT:
+                code.emit(wasm::Op::I64Mul);
+                return &Type::Integer64;
+            case OP_DIVF:
+                code.emit(wasm::Op::I64DivS);
+                return &Type::Integer64;
+            case OP_EQ:
+                code.emit(wasm::Op::I64Eq);
+                return &Type::Boolean;
+            case OP_GT:
+                code.emit(wasm::Op::I64GtS);
+                return &Type::Boolean;
+            case OP_GE:
+                code.emit(wasm::Op::I64GeS);
+                return &Type::Boolean;
+            case OP_LT:
+                code.emit(wasm::Op::I64LtS);
+                return &Type::Boolean;
+            case OP_LE:
+                code.emit(wasm::Op::I64LeS);
+                return &Type::Boolean;
+            default:
+                return Node::gen_wasm(mb);
+            }
+        }
+
 private:
     Node::Ptr m_left, m_right;
 };
 
 class OpAdd : public OpBinary {
 public:
-    OpAdd(const Node::Ptr &left, const Node::Ptr & right) : OpBinary(OP_PLUS, left, right) {}
-
-    Node::Ptr gen_wat(WasmContext &ctx) override {
-        std::string left_wat = get_left()->gen_wat(ctx)->as_string();
-
-        std::string right_wat = get_right()->gen_wat(ctx)->as_string();
-
-        std::string type = get_stmt_type()->as_string();
-        std::string wat_code;
-
-        if (type == "Integer64") {
-            wat_code = FF("{}\n{}\n  i64.add", left_wat, right_wat);
-        } else if (type == "Integer32") {
-            wat_code = FF("{}\n{}\n  i32.add", left_wat, right_wat);
-        } else {
-            throw std::runtime_error("Unsupported type for OpAdd");
-        }
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpAdd; }
 
-        auto result_node = shared_from_this();
-        result_node->set_id(wat_code);
-        return result_node;
-    }
+    OpAdd(const Node::Ptr &left, const Node::Ptr & right)
+            : OpBinary(NodeKind::OpAdd, OP_PLUS, left, right) {}
 };
 
 class OpSub : public OpBinary {
 public:
-    OpSub(const Node::Ptr &left, const Node::Ptr & right) : OpBinary(OP_MINUS, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpSub; }
+
+    OpSub(const Node::Ptr &left, const Node::Ptr & right)
+            : OpBinary(NodeKind::OpSub, OP_MINUS, left, right) {}
 };
 
 class OpMult : public OpBinary {
 public:
-    OpMult(const Node::Ptr &left, const Node::Ptr & right) : OpBinary(OP_MULT, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpMult; }
+
+    OpMult(const Node::Ptr &left, const Node::Ptr & right)
+            : OpBinary(NodeKind::OpMult, OP_MULT, left, right) {}
 };
 
 class OpDivF : public OpBinary {
 public:
-    OpDivF(const Node::Ptr &left, const Node::Ptr & right) : OpBinary(OP_DIVF, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpDivF; }
+
+    OpDivF(const Node::Ptr &left, const Node::Ptr & right)
+            : OpBinary(NodeKind::OpDivF, OP_DIVF, left, right) {}
 };
 
 class AssignNode : public Node {
 public:
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::AssignNode; }
+
     AssignNode(const Node::Ptr &left, const Node::Ptr &right)
-        : Node(OP_ASSIGN), m_left(left), m_right(right) {
+        : Node(NodeKind::AssignNode, OP_ASSIGN), m_left(left), m_right(right) {
             assert(left);
             assert(right);
         }
 
-    std::string as_string() const override {
-        return fmt::format("Assign(l={}, r={})", m_left->as_string(), m_right->as_string());
-    }
+    void dump(Dumper &out) const { out << "Assign(l=" << m_left << ", r=" << m_right << ")"; }
 
-        Node::Ptr compute_stmt_type(SymbolTable &st) override {
-                auto left_type = m_left->compute_stmt_type(st);
-                auto right_type = m_right->compute_stmt_type(st);
+    Node::Ptr get_left() const { return m_left; }
+    Node::Ptr get_right() const { return m_right; }
+
+    // the target is a name, only the value is evaluated
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_right);
+    }
 
-                if (auto identifier_node = std::dynamic_pointer_cast<const ast::Identifier>(m_right)) {
-            const std::string& name = identifier_node->get_name();
+    Node::Ptr compute_stmt_type(SymbolTable &st) override {
+        set_cur_symtab(st.get_cur_symtab());
+        if (auto identifier_node = dyn_cast<ast::Identifier>(m_right)) {
+            auto name = identifier_node->get_name();
             if (st.is_builtin_keyword(name)) {
                 return set_error(fmt::format("Overriding builtin '{}' is not allowed", name));
             }
         }
 
-                
-            if (auto func_node = std::dynamic_pointer_cast<const ast::FuncNode>(m_right)) {
-            right_type = func_node->get_return_type(); 
+        if (auto ret = m_left->compute_stmt_type(st)) {
+            return ret;
+        }
+        if (auto ret = m_right->compute_stmt_type(st)) {
+            return ret;
         }
 
-            if (left_type && right_type) {
-                if (left_type->as_string() != right_type->as_string()) {
-
-                return set_error(fmt::format("Left type '{}' of assignment does not match the right type '{}'", 
-                                             left_type->as_string(), right_type->as_string()));
-            }
+        auto left_type = m_left->get_stmt_type();
+        auto right_type = m_right->get_stmt_type();
+        if (left_type && right_type && ! right_type->converts_to(left_type)) {
+            return set_error(
+                    fmt::format("Left type '{}' of assignment does not match the right type '{}'",
+                                *left_type, *right_type));
         }
 
-        return shared_from_this();
+        return nullptr;
     }
 
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        auto &func = mb.current();
+        auto index = func.locals().find(name_of(m_left));
+        if (! index) {
+            throw std::runtime_error(FF("Assignment target {} is not a local", m_left->as_string()));
+        }
+
+        if (m_right->gen_wasm(mb) != func.locals().get_type(*index)) {
+            throw std::runtime_error(FF("Type mismatch in {}", as_string()));
+        }
+
+        func.emit_local(wasm::Op::LocalSet, *index);
+        return nullptr;
+    }
 
 private:
     Node::Ptr m_left, m_right;
@@ -164,27 +255,42 @@ private:
 
 class OpEq : public OpBinary {
 public:
-    OpEq(const Node::Ptr &left, const Node::Ptr &right) : OpBinary(OP_EQ, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpEq; }
+
+    OpEq(const Node::Ptr &left, const Node::Ptr &right)
+            : OpBinary(NodeKind::OpEq, OP_EQ, left, right) {}
 };
 
 class OpGt : public OpBinary {
 public:
-    OpGt(const Node::Ptr &left, const Node::Ptr &right) : OpBinary(OP_GT, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpGt; }
+
+    OpGt(const Node::Ptr &left, const Node::Ptr &right)
+            : OpBinary(NodeKind::OpGt, OP_GT, left, right) {}
 };
 
 class OpGe : public OpBinary {
 public:
-    OpGe(const Node::Ptr &left, const Node::Ptr &right) : OpBinary(OP_GE, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpGe; }
+
+    OpGe(const Node::Ptr &left, const Node::Ptr &right)
+            : OpBinary(NodeKind::OpGe, OP_GE, left, right) {}
 };
 
 class OpLt : public OpBinary {
 public:
-    OpLt(const Node::Ptr &left, const Node::Ptr &right) : OpBinary(OP_LT, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpLt; }
+
+    OpLt(const Node::Ptr &left, const Node::Ptr &right)
+            : OpBinary(NodeKind::OpLt, OP_LT, left, right) {}
 };
 
 class OpLe : public OpBinary {
 public:
-    OpLe(const Node::Ptr &left, const Node::Ptr &right) : OpBinary(OP_LE, left, right) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::OpLe; }
+
+    OpLe(const Node::Ptr &left, const Node::Ptr &right)
+            : OpBinary(NodeKind::OpLe, OP_LE, left, right) {}
 };
 
 
@@ -0,0 +1,58 @@
+#ifndef KIRAZ_AST_VISIT_H
+#define KIRAZ_AST_VISIT_H
+
+#include <type_traits>
+
+#include <kiraz/Node.h>
+#include <kiraz/ast/FuncNode.h>
+#include <kiraz/ast/KeyNodes.h>
+#include <kiraz/ast/LetNode.h>
+#include <kiraz/ast/Literal.h>
+#include <kiraz/ast/Operator.h>
+#include <kiraz/ast/testModule.h>
+
+namespace ast {
+
+/**
+ * @brief visit: Calls the visitor with the node downcast to its concrete class, chosen by a switch
+ *        over the kind tag, so there is no virtual call and overload resolution happens at compile
+ *        time. The visitor is usually a generic lambda or an overload set; all calls have to
+ *        return the same type. Nodes of unknown kind are passed as plain Node.
+ */
+template <typename N, typename Visitor>
+decltype(auto) visit(N &node, Visitor &&visitor) {
+    static_assert(std::is_base_of_v<Node, std::remove_cv_t<N>>);
+    using Base = std::conditional_t<std::is_const_v<N>, const Node, Node>;
+    auto &base = static_cast<Base &>(node);
+
+    switch (node.get_kind()) {
+#define X(name)                                                                                    \
+    case NodeKind::name:                                                                           \
+        return visitor(static_cast<std::conditional_t<std::is_const_v<N>, const name, name> &>(base));
+        KIRAZ_NODE_KINDS(X)
+#undef X
+    default:
+        break;
+    }
+
+    return visitor(base);
+}
+
+/**
+ * @brief for_each_child: Calls fn with a reference to each non-null child of the given node, see
+ *        Node::for_each_child().
+ */
+template <typename Fn>
+void for_each_child(Node &node, Fn &&fn) {
+    visit(node, [&](auto &n) {
+        n.for_each_child([&](Node::Ptr &child) {
+            if (child) {
+                fn(child);
+            }
+        });
+    });
+}
+
+} // namespace ast
+
+#endif // KIRAZ_AST_VISIT_H
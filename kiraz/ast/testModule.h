@@ -4,20 +4,32 @@
 #include <kiraz/Node.h>
 #include <kiraz/Compiler.h>
 #include <kiraz/ast/FuncNode.h>
+#include <kiraz/ast/KeyNodes.h>
 
 
 namespace ast {
 
 class Module : public Node {
 public:
-    Module(Node::Ptr root) : Node(-1), m_root(root) {}
+    static bool classof(const Node *node) { return node->get_kind() == NodeKind::Module; }
 
-    std::string as_string() const override {
-        if (!m_root) {
-        return ""; 
+    Module(Node::Ptr root) : Node(NodeKind::Module, -1), m_root(root) {}
+
+    void dump(Dumper &out) const {
+        // the statements are a list already
+        if (isa<ast::NodeList>(m_root)) {
+            out << "Module(" << m_root << ")";
+        }
+        else if (m_root) {
+            out << "Module([" << m_root << "])";
+        }
     }
-        return fmt::format("Module([{}])", m_root->as_string());
 
+    Node::Ptr get_body() const { return m_root; }
+
+    template <typename Fn>
+    void for_each_child(Fn &&fn) {
+        fn(m_root);
     }
 
     Node::Ptr compute_stmt_type(SymbolTable &st) override{
@@ -33,10 +45,10 @@ public:
 
         set_cur_symtab(st.get_cur_symtab());
         if(m_root){  
-            auto node_list = std::dynamic_pointer_cast<ast::NodeList>(m_root);
+            auto node_list = dyn_cast<ast::NodeList>(m_root);
             //fmt::print("test{}",node_list==nullptr);
             if (node_list) {
-                auto scope = st.enter_scope(ScopeType::Module, shared_from_this());
+                auto scope = st.enter_scope(ScopeType::Module, this);
                 for (const auto &stmt : node_list->get_list()){
                     if (!stmt){
                         return set_error("testerror");
@@ -61,7 +73,43 @@ public:
         return nullptr;
     }
 
+    const Type *gen_wasm(wasm::ModuleBuilder &mb) const override {
+        std::vector<Node::Ptr> stmts;
+        if (auto node_list = dyn_cast<ast::NodeList>(m_root)) {
+            stmts = node_list->get_list();
+        } else if (m_root) {
+            stmts.push_back(m_root);
+        }
+
+        // declare all functions first so that they can call each other regardless of order
+        for (const auto &stmt : stmts) {
+            if (! emits_code(*stmt)) {
+                continue;
+            }
+
+            auto func = dyn_cast<ast::FuncNode>(stmt);
+            if (! func) {
+                throw std::runtime_error(FF("{} is not supported at module level",
+                        stmt->as_string()));
+            }
+            func->declare(mb);
+        }
+
+        for (const auto &stmt : stmts) {
+            if (emits_code(*stmt)) {
+                stmt->gen_wasm(mb);
+            }
+        }
+        return nullptr;
+    }
+
 private:
+    /**
+     * @brief emits_code: Whether the given statement of the module has code of its own. Imports
+     *        only declare a name for type checking.
+     */
+    static bool emits_code(const Node &stmt) { return ! isa<ast::ImportNode>(&stmt); }
+
     Node::Ptr m_root;
     std::shared_ptr<SymbolTable> m_symtab;
 };
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <kiraz/Compiler.h>
+
+/*
+ * Compiles synthetic programs of scalable size and reports throughput per phase: tokens per
+ * second for scanning and parsing, nodes per second for parsing and type checking, bytes of wat
+ * per second for code generation. Phase times come from the compiler's own TimeReport, so
+ * scanning is measured per token and includes the cost of reading the clock.
+ *
+ * Workloads:
+ *   functions  N small functions
+ *   expr       one expression with N operators
+ *   lets       a chain of N dependent lets
+ *   classes    a class with N members and N methods; no code generation
+ *   control    ifs and whiles nested N deep; no code generation
+ *
+ * Usage: bench_kiraz [scale] [rounds] [workload ...]
+ */
+
+struct Workload {
+    std::string_view name;
+    std::function<std::vector<std::string>(size_t)> generate;
+    bool codegen;
+};
+
+static std::vector<std::string> gen_functions(size_t n) {
+    std::string code;
+    for (size_t i = 0; i < n; ++i) {
+        code += fmt::format("func F{0}(a: Integer64, b: Integer64) : Integer64 {{\n"
+                            "    let c = a * b + {0};\n"
+                            "    let d: Integer64;\n"
+                            "    d = c - a / 2;\n"
+                            "    return d;\n"
+                            "}};\n",
+                i);
+    }
+    return {code};
+}
+
+static std::vector<std::string> gen_expr(size_t n) {
+    std::string code = "func E(a: Integer64) : Integer64 {\n    return a";
+    static constexpr std::string_view ops[] = {" + ", " * ", " - ", " / "};
+    for (size_t i = 0; i < n; ++i) {
+        code += ops[i % std::size(ops)];
+        code += fmt::format("{}", i + 1);
+    }
+    code += ";\n};\n";
+    return {code};
+}
+
+static std::vector<std::string> gen_lets(size_t n) {
+    std::string code = "func L(a: Integer64) : Integer64 {\n    let v0 = a;\n";
+    for (size_t i = 1; i < n; ++i) {
+        code += fmt::format("    let v{} = v{} + {};\n", i, i - 1, i);
+    }
+    code += fmt::format("    return v{};\n}};\n", n ? n - 1 : 0);
+    return {code};
+}
+
+static std::vector<std::string> gen_classes(size_t n) {
+    std::string code = "class C {\n";
+    for (size_t i = 0; i < n; ++i) {
+        code += fmt::format("    let m{} : Integer64;\n", i);
+        code += fmt::format("    func M{}(a: Integer64) : Integer64 {{ return a + {}; }};\n", i, i);
+    }
+    code += "};\n";
+    return {code};
+}
+
+static std::vector<std::string> gen_control(size_t n) {
+    // every level takes a few entries on the parser stack, so the nesting is split into functions
+    static constexpr size_t MaxDepth = 20;
+
+    std::string code;
+    for (size_t first = 0; first < n; first += MaxDepth) {
+        auto depth = std::min(n - first, MaxDepth);
+        code += fmt::format("func W{}(a: Integer64) : Integer64 {{\n", first);
+        for (size_t i = 0; i < depth; ++i) {
+            code += fmt::format("{} (a {} {}) {{\n", i % 2 ? "while" : "if", i % 2 ? '<' : '>', i);
+        }
+        code += "a = a + 1;\n";
+        for (size_t i = depth; i-- > 0;) {
+            code += i % 2 ? "};\n" : "} else { a = a - 1; };\n";
+        }
+        code += "return a;\n};\n";
+    }
+    return {code};
+}
+
+static const Workload workloads[] = {
+        {"functions", gen_functions, true},
+        {"expr", gen_expr, true},
+        {"lets", gen_lets, true},
+        {"classes", gen_classes, false},
+        {"control", gen_control, false},
+};
+
+/**
+ * @brief run: Compiles every module once with a fresh compiler, adding up their reports.
+ * @return false if a module does not compile.
+ */
+static bool run(const Workload &workload, const std::vector<std::string> &modules,
+        TimeReport &total) {
+    for (const auto &code : modules) {
+        TimeReport report;
+        Compiler compiler;
+        compiler.set_report(&report);
+
+        auto status = compiler.compile_string(code);
+        // workloads without code generation fail in it, which is expected
+        if (status != 0 && (workload.codegen || ! Node::get_root_before())) {
+            fmt::print(stderr, "{}: {}", workload.name, compiler.get_error());
+            return false;
+        }
+        total.merge(report);
+    }
+    return true;
+}
+
+static double per_second(size_t amount, std::chrono::nanoseconds time) {
+    if (time.count() == 0) {
+        return 0;
+    }
+    return amount / std::chrono::duration<double>(time).count();
+}
+
+int main(int argc, char **argv) {
+    size_t scale = argc > 1 ? std::stoul(argv[1]) : 5000;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 5;
+    std::vector<std::string_view> selected(argv + std::min(argc, 3), argv + argc);
+
+    using Phase = TimeReport::Phase;
+    fmt::print("scale {}, best of {} rounds\n", scale, rounds);
+    fmt::print("{:<10} {:>8} {:>9} {:>9} {:>10} | {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+            "workload", "modules", "tokens", "nodes", "wat bytes", "scan Mt/s", "parse Mt/s",
+            "parse Mn/s", "check Mn/s", "gen MB/s");
+
+    for (const auto &workload : workloads) {
+        if (! selected.empty()
+                && std::find(selected.begin(), selected.end(), workload.name) == selected.end()) {
+            continue;
+        }
+
+        auto modules = workload.generate(scale);
+
+        // keep the fastest round for each phase
+        TimeReport best;
+        for (size_t round = 0; round < rounds; ++round) {
+            TimeReport total;
+            if (! run(workload, modules, total)) {
+                return 1;
+            }
+            best = round ? TimeReport::best_of(best, total) : total;
+        }
+
+        const auto &counts = best.counts();
+        fmt::print("{:<10} {:>8} {:>9} {:>9} {:>10} | {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} ",
+                workload.name, modules.size(), counts.tokens, counts.nodes, counts.bytes,
+                per_second(counts.tokens, best.get(Phase::Scan).wall) / 1e6,
+                per_second(counts.tokens, best.get(Phase::Parse).wall) / 1e6,
+                per_second(counts.nodes, best.get(Phase::Parse).wall) / 1e6,
+                per_second(counts.nodes, best.get(Phase::Check).wall) / 1e6);
+        if (workload.codegen) {
+            fmt::print("{:>10.2f}\n",
+                    per_second(counts.bytes, best.get(Phase::Codegen).wall) / 1e6);
+        } else {
+            fmt::print("{:>10}\n", "-");
+        }
+    }
+
+    return 0;
+}
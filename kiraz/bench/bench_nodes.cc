@@ -0,0 +1,49 @@
+
+#include <chrono>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <kiraz/Node.h>
+#include <kiraz/ParseContext.h>
+
+/*
+ * Parses a large number of synthetic statements into one context and reports how much memory
+ * their syntax trees take. Only the arena is counted, ie. node objects including whatever members
+ * they embed, not what those members allocate on their own.
+ *
+ * Usage: bench_nodes [statement count]
+ */
+
+static std::string generate(size_t count) {
+    std::string retval;
+    for (size_t i = 0; i < count; ++i) {
+        retval += fmt::format("let a{0} : Integer64 = {0} + (b{0} * 2);\n", i);
+    }
+    return retval;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    auto code = generate(count);
+
+    ParseContext ctx;
+    auto start = std::chrono::steady_clock::now();
+    if (ctx.parse(code) != 0) {
+        fmt::print(stderr, "{}", ctx.get_error());
+        return 1;
+    }
+    ctx.reset();
+    auto end = std::chrono::steady_clock::now();
+
+    const auto &arena = ctx.get_arena();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    fmt::print("statements      : {}\n", count);
+    fmt::print("nodes           : {}\n", arena.get_count());
+    fmt::print("sizeof(Node)    : {} bytes\n", sizeof(Node));
+    fmt::print("arena           : {} bytes\n", arena.get_size());
+    fmt::print("bytes per node  : {:.1f}\n", double(arena.get_size()) / arena.get_count());
+    fmt::print("parse           : {:.1f} ns per node\n", double(ns) / arena.get_count());
+
+    return 0;
+}
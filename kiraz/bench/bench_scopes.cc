@@ -0,0 +1,85 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/ast/Literal.h>
+
+/*
+ * Declares a large number of module level symbols, then enters a deep chain of nested scopes,
+ * declaring a few symbols and looking up both local and module level names at each level. This is
+ * what type checking does for deeply nested code in a big module, on the symbol table alone.
+ *
+ * Usage: bench_scopes [module symbols] [depth] [rounds]
+ */
+
+static constexpr size_t LocalsPerScope = 4;
+
+int main(int argc, char **argv) {
+    size_t globals = argc > 1 ? std::stoul(argv[1]) : 5000;
+    size_t depth = argc > 2 ? std::stoul(argv[2]) : 200;
+    size_t rounds = argc > 3 ? std::stoul(argv[3]) : 100;
+
+    Compiler compiler;
+    ParseContext &ctx = *ParseContext::current();
+
+    std::vector<Symbol> global_names, local_names;
+    for (size_t i = 0; i < globals; ++i) {
+        global_names.push_back(Symbol::intern(fmt::format("g{}", i)));
+    }
+    for (size_t i = 0; i < depth * LocalsPerScope; ++i) {
+        local_names.push_back(Symbol::intern(fmt::format("l{}", i)));
+    }
+    auto node = ctx.make<ast::Identifier>(global_names.front());
+
+    SymbolTable st(ScopeType::Module);
+    for (auto name : global_names) {
+        st.add_symbol(name, node);
+    }
+
+    using clock = std::chrono::steady_clock;
+    clock::duration enter{}, lookup{};
+    size_t found = 0;
+
+    // ScopeRef exits its scope when destroyed, so the nesting is done by recursion
+    auto descend = [&](auto &self, size_t round, size_t level) -> void {
+        if (level == depth) {
+            return;
+        }
+
+        node->set_cur_symtab(st.get_cur_symtab());
+        auto start = clock::now();
+        auto scope = st.enter_scope(ScopeType::Func, node);
+        enter += clock::now() - start;
+
+        for (size_t i = 0; i < LocalsPerScope; ++i) {
+            st.add_symbol(local_names[level * LocalsPerScope + i], node);
+        }
+
+        start = clock::now();
+        found += bool(st.get_symbol(local_names[level * LocalsPerScope]));
+        found += bool(st.get_symbol(global_names[(round * depth + level) % globals]));
+        lookup += clock::now() - start;
+
+        self(self, round, level + 1);
+    };
+
+    for (size_t round = 0; round < rounds; ++round) {
+        descend(descend, round, 0);
+    }
+
+    auto ns = [](clock::duration d) {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    };
+    auto levels = double(depth * rounds);
+    fmt::print("module symbols  : {}\n", globals);
+    fmt::print("depth           : {}\n", depth);
+    fmt::print("rounds          : {}\n", rounds);
+    fmt::print("found           : {} of {}\n", found, 2 * depth * rounds);
+    fmt::print("enter_scope     : {:.1f} ns per scope\n", ns(enter) / levels);
+    fmt::print("get_symbol      : {:.1f} ns per lookup\n", ns(lookup) / levels / 2);
+
+    return 0;
+}
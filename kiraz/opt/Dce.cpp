@@ -0,0 +1,212 @@
+
+#include "Optimize.h"
+
+#include <algorithm>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <kiraz/ast/Visit.h>
+
+namespace opt {
+
+namespace {
+
+std::optional<bool> condition_of(const Node *node) {
+    if (auto id = dyn_cast<ast::Identifier>(node); id && id->is_boolean()) {
+        return id->get_name() == sym::True;
+    }
+    return std::nullopt;
+}
+
+void count_declared(Node &node, std::unordered_map<Symbol, int> &names) {
+    if (auto let = dyn_cast<ast::LetNode>(&node)) {
+        ++names[let->get_name()];
+    }
+    ast::for_each_child(node, [&](Node::Ptr &child) { count_declared(*child, names); });
+}
+
+class Eliminator {
+public:
+    /**
+     * @brief run: Drops the statements that can not run from the tree in the given slot.
+     */
+    void run(Node::Ptr &slot);
+
+private:
+    void prune_function(ast::FuncNode &func);
+    void prune_list(ast::NodeList &list);
+
+    /**
+     * @brief append: Adds the given statement to a list, or the statements of the branch it
+     *        always takes, or nothing if it never does anything.
+     */
+    void append(std::vector<Node::Ptr> &stmts, Node::Ptr stmt);
+
+    /**
+     * @brief can_splice: Whether the statements of the given branch can move into the enclosing
+     *        list, that is none of its lets has the name of another local of the function.
+     */
+    bool can_splice(const ast::NodeList &branch) const;
+
+    // how often each name is declared as a parameter or let in the current function
+    std::unordered_map<Symbol, int> m_declared;
+};
+
+void Eliminator::run(Node::Ptr &slot) {
+    ast::visit(*slot, [&](auto &node) {
+        using T = std::remove_cvref_t<decltype(node)>;
+
+        if constexpr (std::is_same_v<T, ast::FuncNode>) {
+            prune_function(node);
+        }
+        else if constexpr (std::is_same_v<T, ast::NodeList>) {
+            prune_list(node);
+        }
+        else {
+            ast::for_each_child(node, [&](Node::Ptr &child) { run(child); });
+        }
+    });
+}
+
+void Eliminator::prune_function(ast::FuncNode &func) {
+    std::unordered_map<Symbol, int> declared;
+    if (auto args = dyn_cast<ast::FuncArgs>(func.get_arg_list())) {
+        for (const auto &arg : args->get_list()) {
+            ++declared[ast::name_of(cast<ast::ArgNode>(arg)->get_name())];
+        }
+    }
+    count_declared(func, declared);
+
+    std::swap(m_declared, declared);
+    ast::for_each_child(func, [&](Node::Ptr &child) { run(child); });
+    std::swap(m_declared, declared);
+}
+
+void Eliminator::prune_list(ast::NodeList &list) {
+    auto &stmts = list.get_list();
+    for (auto &stmt : stmts) {
+        run(stmt);
+    }
+
+    std::vector<Node::Ptr> kept;
+    for (const auto &stmt : stmts) {
+        auto first = kept.size();
+        append(kept, stmt);
+
+        // nothing after a return runs
+        auto ret = std::find_if(kept.begin() + first, kept.end(),
+                [](const Node::Ptr &node) { return isa<ast::ReturnNode>(node); });
+        if (ret != kept.end()) {
+            kept.erase(ret + 1, kept.end());
+            break;
+        }
+    }
+    stmts = std::move(kept);
+}
+
+void Eliminator::append(std::vector<Node::Ptr> &stmts, Node::Ptr stmt) {
+    if (auto if_node = dyn_cast<ast::IfNode>(stmt)) {
+        if (auto condition = condition_of(if_node->get_condition())) {
+            auto branch = *condition ? if_node->get_then() : if_node->get_else();
+            if (! branch) {
+                return;
+            }
+
+            auto list = dyn_cast<ast::NodeList>(branch);
+            if (! list) {
+                // else if
+                append(stmts, branch);
+                return;
+            }
+            if (can_splice(*list)) {
+                stmts.insert(stmts.end(), list->get_list().begin(), list->get_list().end());
+                return;
+            }
+        }
+    }
+
+    if (auto while_node = dyn_cast<ast::WhileNode>(stmt)) {
+        if (condition_of(while_node->get_condition()) == false) {
+            return;
+        }
+    }
+
+    stmts.push_back(stmt);
+}
+
+bool Eliminator::can_splice(const ast::NodeList &branch) const {
+    for (const auto &stmt : branch.get_list()) {
+        if (auto let = dyn_cast<ast::LetNode>(stmt)) {
+            if (auto found = m_declared.find(let->get_name());
+                    found != m_declared.end() && found->second > 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief remove_unreachable: Drops the functions of the module that can not be called from its
+ *        entry points.
+ */
+void remove_unreachable(ast::Module &module, const Options &options) {
+    auto slots = module_statements(module);
+
+    std::unordered_map<Symbol, ast::FuncNode *> functions;
+    for (auto slot : slots) {
+        if (auto func = dyn_cast<ast::FuncNode>(*slot)) {
+            functions[ast::name_of(func->get_name())] = func;
+        }
+    }
+
+    std::vector<Symbol> pending = options.entry_points;
+    if (pending.empty()) {
+        for (const auto &[name, func] : functions) {
+            pending.push_back(name);
+        }
+    }
+
+    std::unordered_set<Symbol> reachable;
+    while (! pending.empty()) {
+        auto name = pending.back();
+        pending.pop_back();
+
+        auto func = functions.find(name);
+        if (func == functions.end() || ! reachable.insert(name).second) {
+            continue;
+        }
+
+        std::unordered_set<Symbol> callees;
+        collect_callees(*func->second, callees);
+        pending.insert(pending.end(), callees.begin(), callees.end());
+    }
+
+    for (auto slot : slots) {
+        if (auto func = dyn_cast<ast::FuncNode>(*slot);
+                func && ! reachable.contains(ast::name_of(func->get_name()))) {
+            *slot = nullptr;
+        }
+    }
+
+    module.for_each_child([](Node::Ptr &body) {
+        if (auto list = dyn_cast<ast::NodeList>(body)) {
+            std::erase(list->get_list(), nullptr);
+        }
+    });
+}
+
+} // namespace
+
+void eliminate_dead_code(Node::Ptr root, const Options &options) {
+    Eliminator().run(root);
+    if (auto module = dyn_cast<ast::Module>(root)) {
+        remove_unreachable(*module, options);
+    }
+}
+
+} // namespace opt
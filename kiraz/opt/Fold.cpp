@@ -0,0 +1,244 @@
+
+#include "Optimize.h"
+
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <kiraz/ParseContext.h>
+#include <kiraz/Type.h>
+#include <kiraz/ast/Visit.h>
+
+namespace opt {
+
+namespace {
+
+/**
+ * @brief Constant: The value of a constant expression, an Integer64 or a Boolean.
+ */
+struct Constant {
+    const Type *type;
+    int64_t value;
+};
+
+std::optional<Constant> constant_of(const Node *node) {
+    if (auto integer = dyn_cast<ast::Integer>(node)) {
+        return Constant{&Type::Integer64, integer->get_value()};
+    }
+    if (auto id = dyn_cast<ast::Identifier>(node); id && id->is_boolean()) {
+        return Constant{&Type::Boolean, id->get_name() == sym::True};
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief evaluate: The given operator applied to two constants the way wasm computes it, nothing
+ *        if the operation traps or is not defined on the operands.
+ */
+std::optional<Constant> evaluate(int op, const Constant &left, const Constant &right) {
+    if (left.type != &Type::Integer64 || right.type != &Type::Integer64) {
+        return std::nullopt;
+    }
+
+    // i64 arithmetic wraps around
+    auto l = uint64_t(left.value);
+    auto r = uint64_t(right.value);
+    switch (op) {
+    case OP_PLUS:
+        return Constant{&Type::Integer64, int64_t(l + r)};
+    case OP_MINUS:
+        return Constant{&Type::Integer64, int64_t(l - r)};
+    case OP_MULT:
+        return Constant{&Type::Integer64, int64_t(l * r)};
+    case OP_DIVF:
+        if (right.value == 0 || (left.value == INT64_MIN && right.value == -1)) {
+            return std::nullopt;
+        }
+        return Constant{&Type::Integer64, left.value / right.value};
+    case OP_EQ:
+        return Constant{&Type::Boolean, left.value == right.value};
+    case OP_GT:
+        return Constant{&Type::Boolean, left.value > right.value};
+    case OP_GE:
+        return Constant{&Type::Boolean, left.value >= right.value};
+    case OP_LT:
+        return Constant{&Type::Boolean, left.value < right.value};
+    case OP_LE:
+        return Constant{&Type::Boolean, left.value <= right.value};
+    default:
+        return std::nullopt;
+    }
+}
+
+void collect_assigned(Node &node, std::unordered_set<Symbol> &names) {
+    if (auto assign = dyn_cast<ast::AssignNode>(&node)) {
+        names.insert(ast::name_of(assign->get_left()));
+    }
+    ast::for_each_child(node, [&](Node::Ptr &child) { collect_assigned(*child, names); });
+}
+
+class Folder {
+public:
+    explicit Folder(ParseContext &ctx) : m_ctx(ctx) {}
+
+    /**
+     * @brief run: Folds the tree in the given slot, replacing it if it is constant.
+     */
+    void run(Node::Ptr &slot);
+
+private:
+    void fold_function(ast::FuncNode &func);
+    void fold_list(ast::NodeList &list);
+
+    /**
+     * @brief propagate: Takes note of the value of the given let if it is a constant that can be
+     *        substituted for its uses.
+     * @return true if it is, in which case the let is not needed any more.
+     */
+    bool propagate(const ast::LetNode &let);
+
+    std::optional<Constant> find(Symbol name) const;
+    Node::Ptr make_constant(const Constant &constant, const Node &at);
+
+    ParseContext &m_ctx;
+    const ast::FuncNode *m_function = nullptr;
+    std::unordered_set<Symbol> m_assigned;
+
+    // lets of the enclosing statement lists, innermost last; nothing for those that are not
+    // constant but hide an outer one
+    std::vector<std::unordered_map<Symbol, std::optional<Constant>>> m_scopes;
+};
+
+void Folder::run(Node::Ptr &slot) {
+    ast::visit(*slot, [&](auto &node) {
+        using T = std::remove_cvref_t<decltype(node)>;
+
+        if constexpr (std::is_same_v<T, ast::FuncNode>) {
+            fold_function(node);
+        }
+        else if constexpr (std::is_same_v<T, ast::NodeList>) {
+            fold_list(node);
+        }
+        else if constexpr (std::is_same_v<T, ast::ClassNode>) {
+            // members are not locals
+            auto function = std::exchange(m_function, nullptr);
+            ast::for_each_child(node, [&](Node::Ptr &child) { run(child); });
+            m_function = function;
+        }
+        else if constexpr (std::is_same_v<T, ast::Identifier>) {
+            if (auto constant = find(node.get_name())) {
+                slot = make_constant(*constant, node);
+            }
+        }
+        else {
+            ast::for_each_child(node, [&](Node::Ptr &child) { run(child); });
+
+            if constexpr (std::is_base_of_v<ast::OpBinary, T>) {
+                auto left = constant_of(node.get_left());
+                auto right = constant_of(node.get_right());
+                if (left && right) {
+                    if (auto result = evaluate(node.get_id(), *left, *right)) {
+                        slot = make_constant(*result, node);
+                    }
+                }
+            }
+            else if constexpr (std::is_same_v<T, ast::SignedNode>) {
+                auto operand = constant_of(node.get_operand());
+                if (operand && operand->type == &Type::Integer64) {
+                    if (node.get_operator() == OP_MINUS) {
+                        operand->value = int64_t(0 - uint64_t(operand->value));
+                    }
+                    slot = make_constant(*operand, node);
+                }
+            }
+        }
+    });
+}
+
+void Folder::fold_function(ast::FuncNode &func) {
+    // constants do not cross function boundaries
+    std::unordered_set<Symbol> assigned;
+    collect_assigned(func, assigned);
+
+    auto function = std::exchange(m_function, &func);
+    auto scopes = std::exchange(m_scopes, {});
+    std::swap(m_assigned, assigned);
+
+    ast::for_each_child(func, [&](Node::Ptr &child) { run(child); });
+
+    std::swap(m_assigned, assigned);
+    m_scopes = std::move(scopes);
+    m_function = function;
+}
+
+void Folder::fold_list(ast::NodeList &list) {
+    m_scopes.emplace_back();
+
+    // lets that were substituted are dropped, the following statements move up
+    auto &stmts = list.get_list();
+    size_t kept = 0;
+    for (auto &stmt : stmts) {
+        run(stmt);
+        if (auto let = dyn_cast<ast::LetNode>(stmt); let && propagate(*let)) {
+            continue;
+        }
+        stmts[kept++] = stmt;
+    }
+    stmts.resize(kept);
+
+    m_scopes.pop_back();
+}
+
+bool Folder::propagate(const ast::LetNode &let) {
+    auto &scope = m_scopes.back();
+    scope[let.get_name()] = std::nullopt;
+
+    auto constant = constant_of(let.get_initializer());
+    if (! m_function || ! constant || m_assigned.contains(let.get_name())) {
+        return false;
+    }
+
+    // code generation reports a mismatch with the explicit type, leave it to that
+    auto type = let.get_type_name();
+    if (type && Type::get_builtin(ast::name_of(type)) != constant->type) {
+        return false;
+    }
+
+    scope[let.get_name()] = constant;
+    return true;
+}
+
+std::optional<Constant> Folder::find(Symbol name) const {
+    for (auto iter = m_scopes.rbegin(); iter != m_scopes.rend(); ++iter) {
+        if (auto found = iter->find(name); found != iter->end()) {
+            return found->second;
+        }
+    }
+    return std::nullopt;
+}
+
+Node::Ptr Folder::make_constant(const Constant &constant, const Node &at) {
+    Node::Ptr retval;
+    if (constant.type == &Type::Boolean) {
+        retval = m_ctx.make<ast::Identifier>(constant.value ? sym::True : sym::False);
+    }
+    else {
+        retval = m_ctx.make<ast::Integer>(constant.value);
+    }
+
+    retval->set_pos(at.get_line(), at.get_col());
+    retval->set_stmt_type(constant.type);
+    return retval;
+}
+
+} // namespace
+
+void fold_constants(Node::Ptr root, ParseContext &ctx) {
+    Folder(ctx).run(root);
+}
+
+} // namespace opt
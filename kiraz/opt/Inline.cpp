@@ -0,0 +1,325 @@
+
+#include "Optimize.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <kiraz/ParseContext.h>
+#include <kiraz/ast/Visit.h>
+
+namespace opt {
+
+namespace {
+
+// inlined bodies are searched for calls to inline in turn, this many levels deep
+constexpr int MaxDepth = 4;
+
+/**
+ * @brief Callee: A function that can be inlined, one that only returns an expression of its
+ *        parameters.
+ */
+struct Callee {
+    std::vector<Symbol> params;
+    Node::Ptr value;
+};
+
+/**
+ * @brief size_of: The number of nodes in the given expression, nothing if it contains something
+ *        an inlined body can not: statements, or names other than the given parameters.
+ */
+std::optional<size_t> size_of(Node &node, const std::vector<Symbol> &params) {
+    if (auto id = dyn_cast<ast::Identifier>(&node)) {
+        if (id->is_boolean() || std::ranges::find(params, id->get_name()) != params.end()) {
+            return 1;
+        }
+        return std::nullopt;
+    }
+
+    if (! isa<ast::Integer>(&node) && ! isa<ast::SignedNode>(&node) && ! isa<ast::OpBinary>(&node)
+            && ! isa<ast::CallNode>(&node) && ! isa<ast::FuncArgs>(&node)) {
+        return std::nullopt;
+    }
+
+    std::optional<size_t> retval = 1;
+    ast::for_each_child(node, [&](Node::Ptr &child) {
+        auto size = retval ? size_of(*child, params) : std::nullopt;
+        retval = size ? std::optional(*retval + *size) : std::nullopt;
+    });
+    return retval;
+}
+
+/**
+ * @brief is_pure: Whether evaluating the given expression can neither have an effect nor trap,
+ *        so that it can be moved.
+ */
+bool is_pure(Node &node) {
+    if (isa<ast::CallNode>(&node) || isa<ast::OpDivF>(&node)) {
+        return false;
+    }
+
+    bool retval = true;
+    ast::for_each_child(node, [&](Node::Ptr &child) { retval = retval && is_pure(*child); });
+    return retval;
+}
+
+size_t count_uses(Node &node, Symbol name) {
+    if (auto id = dyn_cast<ast::Identifier>(&node)) {
+        return id->get_name() == name;
+    }
+
+    size_t retval = 0;
+    ast::for_each_child(node, [&](Node::Ptr &child) { retval += count_uses(*child, name); });
+    return retval;
+}
+
+class Inliner {
+public:
+    Inliner(ParseContext &ctx, const Options &options) : m_ctx(ctx), m_options(options) {}
+
+    void run(ast::Module &module);
+
+private:
+    void find_callees(const std::unordered_map<Symbol, ast::FuncNode *> &functions);
+
+    void inline_list(ast::NodeList &list);
+    void inline_stmt(Node::Ptr &slot);
+
+    /**
+     * @brief inline_calls: Replaces the calls in the given expression by the bodies of their
+     *        callees.
+     */
+    void inline_calls(Node::Ptr &slot, int depth);
+
+    /**
+     * @brief expand: The body of the callee with the arguments of the given call substituted for
+     *        its parameters, nullptr if the call can not be inlined.
+     */
+    Node::Ptr expand(const ast::CallNode &call, const Callee &callee);
+
+    Node::Ptr copy(const Node &node);
+    Node::Ptr substitute(const Node &node, const std::unordered_map<Symbol, Node::Ptr> &args);
+
+    ParseContext &m_ctx;
+    const Options &m_options;
+    std::unordered_map<Symbol, Callee> m_callees;
+
+    // lets for the arguments of calls inlined into the current statement, which go before it;
+    // none can be added where the statement would not evaluate them each time
+    std::vector<Node::Ptr> m_hoisted;
+    bool m_can_hoist = false;
+    size_t m_next_local = 0;
+};
+
+void Inliner::run(ast::Module &module) {
+    std::unordered_map<Symbol, ast::FuncNode *> functions;
+    for (auto slot : module_statements(module)) {
+        if (auto func = dyn_cast<ast::FuncNode>(*slot)) {
+            functions[ast::name_of(func->get_name())] = func;
+        }
+    }
+
+    find_callees(functions);
+    if (m_callees.empty()) {
+        return;
+    }
+
+    for (const auto &[name, func] : functions) {
+        if (auto body = dyn_cast<ast::NodeList>(func->get_body())) {
+            inline_list(*body);
+        }
+    }
+}
+
+void Inliner::find_callees(const std::unordered_map<Symbol, ast::FuncNode *> &functions) {
+    for (const auto &[name, func] : functions) {
+        auto body = dyn_cast<ast::NodeList>(func->get_body());
+        if (! body || body->get_list().size() != 1) {
+            continue;
+        }
+
+        auto ret = dyn_cast<ast::ReturnNode>(body->get_list().front());
+        if (! ret || ! ret->get_value()) {
+            continue;
+        }
+
+        Callee callee{{}, ret->get_value()};
+        if (auto args = dyn_cast<ast::FuncArgs>(func->get_arg_list())) {
+            for (const auto &arg : args->get_list()) {
+                callee.params.push_back(ast::name_of(cast<ast::ArgNode>(arg)->get_name()));
+            }
+        }
+
+        auto size = size_of(*callee.value, callee.params);
+        if (! size || *size > size_t(m_options.inline_threshold)) {
+            continue;
+        }
+
+        // recursive functions would only be unrolled
+        std::unordered_set<Symbol> seen;
+        std::vector<Symbol> pending{name};
+        bool recursive = false;
+        while (! pending.empty() && ! recursive) {
+            auto next = functions.find(pending.back());
+            pending.pop_back();
+            if (next == functions.end()) {
+                continue;
+            }
+
+            std::unordered_set<Symbol> callees;
+            collect_callees(*next->second, callees);
+            for (auto called : callees) {
+                recursive = recursive || called == name;
+                if (seen.insert(called).second) {
+                    pending.push_back(called);
+                }
+            }
+        }
+
+        if (! recursive) {
+            m_callees.emplace(name, std::move(callee));
+        }
+    }
+}
+
+void Inliner::inline_list(ast::NodeList &list) {
+    auto hoisted = std::exchange(m_hoisted, {});
+
+    std::vector<Node::Ptr> stmts;
+    for (auto stmt : list.get_list()) {
+        inline_stmt(stmt);
+        stmts.insert(stmts.end(), m_hoisted.begin(), m_hoisted.end());
+        stmts.push_back(stmt);
+        m_hoisted.clear();
+    }
+    list.get_list() = std::move(stmts);
+
+    m_hoisted = std::move(hoisted);
+}
+
+void Inliner::inline_stmt(Node::Ptr &slot) {
+    ast::visit(*slot, [&](auto &node) {
+        using T = std::remove_cvref_t<decltype(node)>;
+
+        if constexpr (std::is_same_v<T, ast::NodeList>) {
+            inline_list(node);
+        }
+        else if constexpr (std::is_same_v<T, ast::IfNode> || std::is_same_v<T, ast::WhileNode>) {
+            // a condition is not a statement to put lets before, and that of a loop is
+            // evaluated more than once
+            ast::for_each_child(node, [&](Node::Ptr &child) {
+                if (isa<ast::NodeList>(child) || isa<ast::IfNode>(child)) {
+                    inline_stmt(child);
+                    return;
+                }
+                m_can_hoist = false;
+                inline_calls(child, 0);
+            });
+        }
+        else if constexpr (! std::is_same_v<T, ast::FuncNode> && ! std::is_same_v<T, ast::ClassNode>) {
+            m_can_hoist = true;
+            inline_calls(slot, 0);
+        }
+    });
+}
+
+void Inliner::inline_calls(Node::Ptr &slot, int depth) {
+    ast::for_each_child(*slot, [&](Node::Ptr &child) { inline_calls(child, depth); });
+
+    auto call = dyn_cast<ast::CallNode>(slot);
+    if (! call || depth >= MaxDepth) {
+        return;
+    }
+
+    auto callee = m_callees.find(ast::name_of(call->get_name()));
+    if (callee == m_callees.end()) {
+        return;
+    }
+
+    if (auto body = expand(*call, callee->second)) {
+        slot = body;
+        inline_calls(slot, depth + 1);
+    }
+}
+
+Node::Ptr Inliner::expand(const ast::CallNode &call, const Callee &callee) {
+    const auto &args = cast<ast::FuncArgs>(call.get_arg_list())->get_list();
+    if (args.size() != callee.params.size()) {
+        return nullptr;
+    }
+
+    // constants and names are used as they are, other arguments are evaluated once, before the
+    // statement, into fresh locals unless the callee uses them once at most
+    std::vector<bool> hoist(args.size());
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (isa<ast::Integer>(args[i]) || isa<ast::Identifier>(args[i])) {
+            continue;
+        }
+        if (! is_pure(*args[i])) {
+            return nullptr;
+        }
+
+        hoist[i] = count_uses(*callee.value, callee.params[i]) > 1;
+        if (hoist[i] && ! m_can_hoist) {
+            return nullptr;
+        }
+    }
+
+    std::unordered_map<Symbol, Node::Ptr> bindings;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (! hoist[i]) {
+            bindings[callee.params[i]] = args[i];
+            continue;
+        }
+
+        // a name no source can declare
+        auto name = Symbol::intern(FF("{}.{}", callee.params[i], m_next_local++));
+        auto let = m_ctx.make<ast::LetNode>(m_ctx.make<ast::Identifier>(name), nullptr, args[i]);
+        let->set_pos(args[i]->get_line(), args[i]->get_col());
+        m_hoisted.push_back(let);
+        bindings[callee.params[i]] = m_ctx.make<ast::Identifier>(name);
+    }
+
+    auto retval = substitute(*callee.value, bindings);
+    retval->set_pos(call.get_line(), call.get_col());
+    return retval;
+}
+
+Node::Ptr Inliner::copy(const Node &node) {
+    return ast::visit(node, [&](const auto &orig) -> Node::Ptr {
+        using T = std::remove_cvref_t<decltype(orig)>;
+        if constexpr (std::is_copy_constructible_v<T> && ! std::is_same_v<T, Node>) {
+            return m_ctx.make<T>(orig);
+        }
+        else {
+            throw std::runtime_error(FF("{} can not be copied", orig.as_string()));
+        }
+    });
+}
+
+Node::Ptr Inliner::substitute(const Node &node, const std::unordered_map<Symbol, Node::Ptr> &args) {
+    if (auto id = dyn_cast<ast::Identifier>(&node)) {
+        if (auto arg = args.find(id->get_name()); arg != args.end()) {
+            return substitute(*arg->second, {});
+        }
+    }
+
+    auto retval = copy(node);
+    ast::for_each_child(*retval, [&](Node::Ptr &child) { child = substitute(*child, args); });
+    return retval;
+}
+
+} // namespace
+
+void inline_functions(Node::Ptr root, ParseContext &ctx, const Options &options) {
+    if (auto module = dyn_cast<ast::Module>(root); module && options.inline_threshold > 0) {
+        Inliner(ctx, options).run(*module);
+    }
+}
+
+} // namespace opt
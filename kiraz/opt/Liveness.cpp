@@ -0,0 +1,61 @@
+
+#include "Optimize.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <kiraz/ast/Visit.h>
+
+namespace opt {
+
+namespace {
+
+/**
+ * @brief collect_uses: Records the given statement index as the last use of every name the tree
+ *        reads or assigns to.
+ */
+void collect_uses(Node &node, size_t index, std::unordered_map<Symbol, size_t> &last) {
+    if (auto id = dyn_cast<ast::Identifier>(&node)) {
+        last[id->get_name()] = index;
+    }
+    else if (auto assign = dyn_cast<ast::AssignNode>(&node)) {
+        last[ast::name_of(assign->get_left())] = index;
+    }
+    ast::for_each_child(node, [&](Node::Ptr &child) { collect_uses(*child, index, last); });
+}
+
+} // namespace
+
+std::vector<Deaths> dead_lets(ast::NodeList &body) {
+    const auto &stmts = body.get_list();
+
+    std::unordered_map<Symbol, size_t> last;
+    for (size_t i = 0; i < stmts.size(); ++i) {
+        collect_uses(*stmts[i], i, last);
+    }
+
+    std::vector<Deaths> retval(stmts.size());
+    for (size_t i = 0; i < stmts.size(); ++i) {
+        auto let = dyn_cast<ast::LetNode>(stmts[i]);
+        if (! let) {
+            continue;
+        }
+
+        // a let that is never used dies right away
+        auto name = let->get_name();
+        auto found = last.find(name);
+        auto end = found != last.end() ? std::max(found->second, i) : i;
+
+        auto dies_at = dyn_cast<ast::LetNode>(stmts[end]);
+        if (end != i && dies_at && dies_at->get_initializer()) {
+            retval[end].before.push_back(name);
+        }
+        else {
+            retval[end].after.push_back(name);
+        }
+    }
+    return retval;
+}
+
+} // namespace opt
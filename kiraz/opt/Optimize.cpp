@@ -0,0 +1,76 @@
+
+#include "Optimize.h"
+
+#include <charconv>
+
+#include <kiraz/ast/Visit.h>
+
+namespace opt {
+
+bool parse_level(std::string_view digits, Options &options) {
+    if (digits.empty()) {
+        options.level = 1;
+        return true;
+    }
+
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), options.level);
+    return ec == std::errc() && ptr == digits.data() + digits.size() && options.level >= 0;
+}
+
+void collect_callees(Node &node, std::unordered_set<Symbol> &names) {
+    if (auto call = dyn_cast<ast::CallNode>(&node)) {
+        names.insert(ast::name_of(call->get_name()));
+    }
+    ast::for_each_child(node, [&](Node::Ptr &child) { collect_callees(*child, names); });
+}
+
+std::vector<Node::Ptr *> module_statements(ast::Module &module) {
+    // the statements of a module are a list, unless there is only one
+    std::vector<Node::Ptr *> retval;
+    module.for_each_child([&](Node::Ptr &body) {
+        if (auto list = dyn_cast<ast::NodeList>(body)) {
+            for (auto &stmt : list->get_list()) {
+                retval.push_back(&stmt);
+            }
+        }
+        else if (body) {
+            retval.push_back(&body);
+        }
+    });
+    return retval;
+}
+
+std::vector<Symbol> missing_entry_points(ast::Module &module, const Options &options) {
+    std::unordered_set<Symbol> functions;
+    for (auto slot : module_statements(module)) {
+        if (auto func = dyn_cast<ast::FuncNode>(*slot)) {
+            functions.insert(ast::name_of(func->get_name()));
+        }
+    }
+
+    std::vector<Symbol> retval;
+    for (auto name : options.entry_points) {
+        if (! functions.contains(name)) {
+            retval.push_back(name);
+        }
+    }
+    return retval;
+}
+
+void optimize(Node::Ptr root, ParseContext &ctx, const Options &options) {
+    if (options.level >= 1) {
+        fold_constants(root, ctx);
+    }
+
+    // inlined bodies often have constant arguments
+    if (options.level >= 2) {
+        inline_functions(root, ctx, options);
+        fold_constants(root, ctx);
+    }
+
+    if (options.level >= 1) {
+        eliminate_dead_code(root, options);
+    }
+}
+
+} // namespace opt
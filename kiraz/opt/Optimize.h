@@ -0,0 +1,105 @@
+#ifndef KIRAZ_OPT_OPTIMIZE_H
+#define KIRAZ_OPT_OPTIMIZE_H
+
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <kiraz/Node.h>
+
+class ParseContext;
+
+namespace ast {
+class Module;
+class NodeList;
+}
+
+/**
+ * Optimizations on checked syntax trees. They run between type checking and code generation and
+ * rewrite the tree in place. New nodes are made in the arena of the given context; nodes that are
+ * replaced stay there, unreferenced.
+ */
+namespace opt {
+
+/**
+ * @brief Options: How hard to optimize. Level 0 leaves the tree as it is, level 1 folds
+ *        constants and removes dead code, level 2 also inlines functions.
+ */
+struct Options {
+    int level = 0;
+
+    // largest function that is inlined, in nodes of the expression it returns; 0 inlines nothing
+    int inline_threshold = 16;
+
+    // functions that are called from outside, every function of the module if there are none
+    std::vector<Symbol> entry_points;
+};
+
+/**
+ * @brief parse_level: The optimization level in the digits after -O, none meaning level 1.
+ */
+bool parse_level(std::string_view digits, Options &options);
+
+/**
+ * @brief collect_callees: Adds the names of the functions called in the given tree.
+ */
+void collect_callees(Node &node, std::unordered_set<Symbol> &names);
+
+/**
+ * @brief module_statements: The slots of the statements at the top level of the given module.
+ */
+std::vector<Node::Ptr *> module_statements(ast::Module &module);
+
+/**
+ * @brief missing_entry_points: The entry points of the given options that name no function at the
+ *        top level of the given module.
+ */
+std::vector<Symbol> missing_entry_points(ast::Module &module, const Options &options);
+
+/**
+ * @brief Deaths: The lets of a statement list that are not used after one of its statements. If
+ *        the statement is a let itself, those that only its initializer still uses die before it,
+ *        as the initializer is evaluated before the new local is stored.
+ */
+struct Deaths {
+    std::vector<Symbol> before;
+    std::vector<Symbol> after;
+};
+
+/**
+ * @brief dead_lets: Liveness of the lets at the top level of the given body, one entry per
+ *        statement. A use anywhere in a statement, including the branches and loops nested in it,
+ *        keeps a let alive up to the end of that statement.
+ */
+std::vector<Deaths> dead_lets(ast::NodeList &body);
+
+/**
+ * @brief optimize: Runs the passes the given options ask for over the tree of a module.
+ */
+void optimize(Node::Ptr root, ParseContext &ctx, const Options &options);
+
+/**
+ * @brief fold_constants: Computes arithmetic and comparisons on constants, and substitutes the
+ *        value of lets with a constant initializer that are never assigned to for their uses,
+ *        dropping the let. Operations that trap at run time, like division by zero, are kept.
+ */
+void fold_constants(Node::Ptr root, ParseContext &ctx);
+
+/**
+ * @brief eliminate_dead_code: Drops statements that never run: the branch of an if that its
+ *        constant condition rules out, whiles whose condition is false and whatever follows a
+ *        return. Then drops the functions that the entry points do not call, directly or not.
+ */
+void eliminate_dead_code(Node::Ptr root, const Options &options);
+
+/**
+ * @brief inline_functions: Replaces calls to functions that only return an expression, small
+ *        enough for the threshold of the options and not recursive, by that expression. Arguments
+ *        a body uses more than once are evaluated into fresh locals before the statement, unless
+ *        they are constants or names; calls with arguments that have effects are left alone.
+ */
+void inline_functions(Node::Ptr root, ParseContext &ctx, const Options &options);
+
+} // namespace opt
+
+#endif // KIRAZ_OPT_OPTIMIZE_H
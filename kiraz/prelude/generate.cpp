@@ -0,0 +1,57 @@
+
+#include <fstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Prelude.h>
+
+/*
+ * Build step: parses and checks a prelude module and writes it out with prelude::serialize().
+ *
+ * Usage: kiraz_prelude <input.ki> <output.kib>
+ */
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fmt::print(stderr, "Usage: {} <input.ki> <output.kib>\n", argv[0]);
+        return 1;
+    }
+
+    auto source = Source::map_file(argv[1]);
+    if (! source) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    Compiler compiler;
+    auto root = compiler.compile_module(source->text());
+    if (! root) {
+        fmt::print(stderr, "{}: {}", argv[1], compiler.get_error());
+        return 1;
+    }
+
+    SymbolTable st(ScopeType::Module);
+    if (auto ret = root->compute_stmt_type(st)) {
+        fmt::print(stderr, "{}:{}:{}: {}\n", argv[1], ret->get_line(), ret->get_col(),
+                ret->get_error());
+        return 1;
+    }
+
+    std::string blob;
+    try {
+        blob = prelude::serialize(root);
+    } catch (const std::runtime_error &e) {
+        fmt::print(stderr, "{}: {}\n", argv[1], e.what());
+        return 1;
+    }
+
+    std::ofstream f(argv[2], std::ios::binary);
+    f.write(blob.data(), blob.size());
+    if (! f) {
+        perror(argv[2]);
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,8 @@
+
+#include <kiraz/Prelude.h>
+
+#include <resource/PRELUDE_io.h>
+
+std::string_view prelude::io() {
+    return {reinterpret_cast<const char *>(PRELUDE_io), sizeof(PRELUDE_io)};
+}
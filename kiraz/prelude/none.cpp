@@ -0,0 +1,7 @@
+
+#include <kiraz/Prelude.h>
+
+// Linked into the prelude generator, which can not embed what it is about to produce.
+std::string_view prelude::io() {
+    return {};
+}
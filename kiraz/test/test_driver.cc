@@ -0,0 +1,46 @@
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <kiraz/Compiler.h>
+
+namespace kiraz {
+
+/**
+ * Compiling from files, the way kirazc reads its input.
+ */
+struct DriverFixture : public ::testing::Test {
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(DriverFixture, compile_file) {
+    Compiler compiler;
+    std::string code = "func F(a: Integer64) : Integer64 { return a + 1; };";
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+
+    // diagnostics name the file, as perror() used to
+    compiler.reset();
+    ASSERT_NE(compiler.compile_file("missing.ki"), 0);
+    ASSERT_EQ(compiler.get_error(), FF("missing.ki: {}\n", std::strerror(ENOENT)));
+
+#ifndef _WIN32
+    // a pipe has no size to map, it is read instead
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], code.data(), code.size()), ssize_t(code.size()));
+    close(fds[1]);
+
+    compiler.reset();
+    ASSERT_EQ(compiler.compile_file(FF("/dev/fd/{}", fds[0])), 0);
+    close(fds[0]);
+    ASSERT_EQ(compiler.get_wasm_ctx().body().str(), wat);
+#endif
+}
+} // namespace kiraz
@@ -5,11 +5,12 @@
 #include <main.h>
 
 #include <kiraz/Node.h>
-
-extern std::shared_ptr<Token> curtoken;
+#include <kiraz/ParseContext.h>
+#include <kiraz/ast/Literal.h>
+#include <kiraz/ast/Operator.h>
 
 struct ParserFixture : public testing::Test {
-    YY_BUFFER_STATE buffer = nullptr;
+    ParseContext ctx;
 
     void SetUp() override {
         Node::reset_root();
@@ -17,23 +18,13 @@ struct ParserFixture : public testing::Test {
     }
 
     void TearDown() override {
-        // Tear down code after each test, even if assertions fail.
-        // This will be executed even in the face of assertion failures.
-        if (buffer) {
-            yy_delete_buffer(buffer);
-            buffer = nullptr;
-        }
-
         yydebug = 0;
-        Token::colno = 0;
-        curtoken.reset();
+        ctx.reset();
     }
 
     void verify_root(const std::string &code, const std::string &ast) {
-        buffer = yy_scan_string(code.data());
-
         /* perform */
-        yyparse();
+        ctx.parse(code);
 
         /* verify */
         ASSERT_TRUE(Node::current_root());
@@ -42,10 +33,8 @@ struct ParserFixture : public testing::Test {
     }
 
     void verify_single(const std::string &code, const std::string &ast) {
-        buffer = yy_scan_string(code.data());
-
         /* perform */
-        yyparse();
+        ctx.parse(code);
 
         /* verify */
         ASSERT_TRUE(Node::current_root());
@@ -58,10 +47,8 @@ struct ParserFixture : public testing::Test {
     }
 
     void verify_no_root(const std::string &code) {
-        buffer = yy_scan_string(code.data());
-
         /* perform */
-        yyparse();
+        ctx.parse(code);
 
         /* verify */
         ASSERT_FALSE(Node::current_root());
@@ -359,6 +346,12 @@ TEST_F(ParserFixture, module) {
     verify_root("import a; class B {};", "Module([Import(Id(a)), Class(n=Id(B), s=[])])");
 }
 
+TEST_F(ParserFixture, module_keeps_all_statements) {
+    verify_root("let a = 1; func F() : Void {}; let b = a;",
+            "Module([Let(n=Id(a), i=Int(1)), Func(n=Id(F), a=[], r=Id(Void), s=[]), "
+            "Let(n=Id(b), i=Id(a))])");
+}
+
 TEST_F(ParserFixture, if_then_empty) {
     verify_single("if (a) {};", "If(?=Id(a), then=[], else=[])");
 }
@@ -474,6 +467,10 @@ TEST_F(ParserFixture, return_func_call) {
             "Return(Call(n=Dot(l=Id(a), r=Id(b)), a=FuncArgs([Id(c), Id(d), Id(e)])))");
 }
 
+TEST_F(ParserFixture, return_func_call_no_args) {
+    verify_single("return f();", "Return(Call(n=Id(f), a=[]))");
+}
+
 TEST_F(ParserFixture, return_logic) {
     verify_single("return a > b;", "Return(OpGt(l=Id(a), r=Id(b)))");
 }
@@ -485,3 +482,35 @@ TEST_F(ParserFixture, return_bad_operand) {
 TEST_F(ParserFixture, bonus) {
     verify_no_root("1---2;");
 }
+
+TEST_F(ParserFixture, long_stmt_list) {
+    // deeper than the initial parser stack if the list were right recursive
+    constexpr int Count = 5000;
+    std::string code = "func F(a: Integer64) : Integer64 {";
+    for (int i = 0; i < Count; ++i) {
+        code += FF(" let v{} = a;", i);
+    }
+    code += " return a; };";
+
+    ctx.parse(code);
+    ASSERT_TRUE(Node::current_root());
+    auto ast = Node::current_root()->as_string();
+    ASSERT_NE(ast.find("s=[Let(n=Id(v0), i=Id(a)), Let(n=Id(v1), i=Id(a)), "), std::string::npos);
+    ASSERT_NE(ast.find(FF("Let(n=Id(v{}), i=Id(a)), Return(Id(a))]", Count - 1)),
+            std::string::npos);
+}
+
+TEST_F(ParserFixture, dump_deep_tree) {
+    // deep enough to overflow the stack when dumped recursively
+    constexpr int Depth = 200000;
+    Node::Ptr root = ctx.make<ast::Identifier>(Symbol::intern("x"));
+    for (int i = 0; i < Depth; ++i) {
+        root = ctx.make<ast::OpAdd>(root, ctx.make<ast::Identifier>(Symbol::intern("y")));
+    }
+
+    auto dump = root->as_string();
+    ASSERT_EQ(dump.size(), 5 + Depth * std::string_view("Add(l=, r=Id(y))").size());
+    ASSERT_TRUE(dump.starts_with("Add(l=Add(l="));
+    ASSERT_TRUE(dump.ends_with("), r=Id(y)), r=Id(y))"));
+    ASSERT_NE(dump.find("Add(l=Id(x), r=Id(y))"), std::string::npos);
+}
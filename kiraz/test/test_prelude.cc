@@ -0,0 +1,38 @@
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Prelude.h>
+
+#include <resource/FILE_io_ki.h>
+
+namespace kiraz {
+
+/**
+ * Loading of the modules that are precompiled into the compiler.
+ */
+struct PreludeFixture : public ::testing::Test {
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(PreludeFixture, io) {
+    Compiler compiler;
+    auto loaded = compiler.get_module_io();
+    auto parsed = compiler.compile_module(FILE_io_ki);
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(loaded->as_string(), parsed->as_string());
+}
+
+TEST_F(PreludeFixture, count_too_large) {
+    Compiler compiler;
+    auto blob = prelude::serialize(compiler.get_module_io());
+
+    // the header, no symbols and a node count that the rest of the blob can not hold
+    auto corrupt = blob.substr(0, 8) + std::string("\0\0\0\0\xf0\xff\xff\xff", 8);
+    ASSERT_THROW(prelude::load(*ParseContext::current(), corrupt), std::runtime_error);
+    ASSERT_THROW(prelude::load(*ParseContext::current(), blob.substr(0, 8) + "\xf0\xff\xff\xff"),
+            std::runtime_error);
+}
+} // namespace kiraz
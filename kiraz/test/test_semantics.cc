@@ -1,5 +1,6 @@
 
 #include <regex>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -8,6 +9,7 @@
 
 #include <kiraz/Compiler.h>
 #include <kiraz/Node.h>
+#include <kiraz/ast/Visit.h>
 
 extern int yydebug;
 
@@ -142,6 +144,14 @@ TEST_F(CompilerFixture, class_parent_subclass_assignment) {
     verify_ok("class P { let i = 0; }; class C:P {}; func f() : Void { let c: C; let p: P = c; };");
 }
 
+TEST_F(CompilerFixture, class_parent_conversion) {
+    // a derived class converts to its base, not the other way round
+    verify_ok("class P {}; class C:P {}; func F(p: P) : P { let c: C; F(c); return c; };");
+    verify_error("class P {}; class C:P {}; func F() : Void { let p: P; let c: C = p; };",
+            "Initializer type 'P' does not match explicit type 'C'");
+    verify_error("class A:B {}; class B:A {};", "Class 'B' can not derive from itself");
+}
+
 TEST_F(CompilerFixture, class_parent_subsymbol_no_redef) {
     verify_error("class P { let i = 0; }; class C:P {let i = 1; };",
             "Identifier 'i' is already in symtab");
@@ -151,6 +161,16 @@ TEST_F(CompilerFixture, import_missing) {
     verify_error("func f() : Void { io.foo.bar();\n };", "Identifier 'io' is not found");
 }
 
+TEST_F(CompilerFixture, import_module) {
+    verify_ok("import io;");
+    verify_error("import foo;", "Module 'foo' is not found");
+}
+
+TEST_F(CompilerFixture, import_name_taken) {
+    verify_error("let io = 1; import io;", "Identifier 'io' is already in symtab");
+    verify_error("import io; let io = 1;", "Identifier 'io' is already in symtab");
+}
+
 TEST_F(CompilerFixture, func_rettype_missing) {
     verify_error("func f() : R { let a = 5; return a + b; };",
             "Return type 'R' of function 'f' is not found");
@@ -161,6 +181,14 @@ TEST_F(CompilerFixture, func_argtype_missing) {
             "Identifier 'A' in type of argument 'a' in function 'f' is not found");
 }
 
+TEST_F(CompilerFixture, func_argtype_unknown) {
+    verify_ok("func F(a: Integer64) : Void { };");
+
+    // a name that is known but is not a type
+    verify_error("func F(a: F) : Void { };",
+            "Identifier 'F' in type of argument 'a' in function 'F' is not found");
+}
+
 TEST_F(CompilerFixture, func_arg_dup) {
     verify_error("func f(a: Integer64, a: Integer64) : Void { };",
             "Identifier 'a' in argument list of function 'f' is already in symtab");
@@ -223,6 +251,21 @@ TEST_F(CompilerFixture, op_add_type_mismatch) {
             "Operator '+' not defined for types 'Integer64' and 'String'");
 }
 
+TEST_F(CompilerFixture, op_add_type_mismatch_module) {
+    verify_error(R"(let a = 5; let b = "10"; let c = a + b;)",
+            "Operator '+' not defined for types 'Integer64' and 'String'");
+}
+
+TEST_F(CompilerFixture, op_compare_is_boolean) {
+    verify_error("let a = 1 < 2; let b : Integer64 = a;",
+            "Initializer type 'Boolean' does not match explicit type 'Integer64'");
+}
+
+TEST_F(CompilerFixture, op_sub_is_left_type) {
+    verify_error("let a = 1 - 2; let b : Boolean = a;",
+            "Initializer type 'Integer64' does not match explicit type 'Boolean'");
+}
+
 TEST_F(CompilerFixture, class_method_conflict) {
     verify_error("class A { func A() :Void {}; };", "Identifier 'A' is already in symtab");
 }
@@ -248,6 +291,11 @@ TEST_F(CompilerFixture, class_use_before_definition) {
     verify_ok("let a : A; class A { };");
 }
 
+TEST_F(CompilerFixture, class_declared_once) {
+    verify_ok("class A { };");
+    verify_error("class A { }; class A { };", "Identifier 'A' is already in symtab");
+}
+
 TEST_F(CompilerFixture, func_has_and) {
     verify_ok("func m() : Void { and(true, true); };");
 }
@@ -280,6 +328,12 @@ TEST_F(CompilerFixture, func_no_class_def_as_var_name) {
     verify_error("class f {};", "Class name 'f' can not start with an lowercase letter");
 }
 
+TEST_F(CompilerFixture, func_name_lowercase) {
+    // io.ki declares print, so function names are not held to a case
+    verify_ok("func print(s: String) : Void { };");
+    verify_ok("func Print(s: String) : Void { };");
+}
+
 TEST_F(CompilerFixture, func_no_builtin_assignment_and) {
     verify_error("func m() : Void { and = or; };", "Overriding builtin 'and' is not allowed");
 }
@@ -306,6 +360,16 @@ TEST_F(CompilerFixture, func_return_mismatch) {
             "type 'Integer64'");
 }
 
+TEST_F(CompilerFixture, func_body_checked) {
+    // parameters are in scope, nested blocks and recursive calls are checked
+    verify_ok("func F(n: Integer64) : Integer64 { if (n > 0) { return F(n - 1); }; return n; };");
+    verify_error("func F(a: Integer64) : Boolean { if (true) { return a; }; return true; };",
+            "Return statement type 'Integer64' does not match function return type 'Boolean'");
+    verify_error("func F(a: Integer64) : Boolean { return and(a, true); };",
+            "Argument 1 in call to function 'and' has type 'Integer64' which does not match "
+            "definition type 'Boolean'");
+}
+
 TEST_F(CompilerFixture, return_misplaced_module) {
     verify_error(R"(return a;)", "Misplaced return statement");
 }
@@ -328,6 +392,13 @@ TEST_F(CompilerFixture, while_test_str) {
             R"(func f() : Void {while("1") {};};)", "While only accepts tests of type 'Boolean'");
 }
 
+TEST_F(CompilerFixture, while_test_name) {
+    verify_error(R"(let a = "1"; while(a) {};)", "While only accepts tests of type 'Boolean'");
+
+    // a Boolean test passes, the while is misplaced still
+    verify_error("let a = true; while(a) {};", "Misplaced while statement");
+}
+
 TEST_F(CompilerFixture, while_misplaced_module) {
     verify_error(R"(while(true) {};)", "Misplaced while statement");
 }
@@ -398,6 +469,13 @@ TEST_F(CompilerFixture, if_test_str) {
     verify_error(R"(func f():Void{if(1){};};)", "If only accepts tests of type 'Boolean'");
 }
 
+TEST_F(CompilerFixture, if_test_name) {
+    verify_error("let a = 1; if(a) {};", "If only accepts tests of type 'Boolean'");
+
+    // a Boolean test passes, the if is misplaced still
+    verify_error("let a = 1 < 2; if(a) {};", "Misplaced if statement");
+}
+
 TEST_F(CompilerFixture, if_else_test_str) {
     verify_ok(R"(func f():Void{if(false){} else {};};)");
 }
@@ -441,12 +519,34 @@ TEST_F(CompilerFixture, let_type_mismatch_var) {
             "Initializer type 'String' does not match explicit type 'Integer64'");
 }
 
+TEST_F(CompilerFixture, let_type_mismatch_module) {
+    verify_error(R"(let h : Integer64 = "string";)",
+            "Initializer type 'String' does not match explicit type 'Integer64'");
+    verify_error("class A {}; let a : A = 1;",
+            "Initializer type 'Integer64' does not match explicit type 'A'");
+    verify_error("func G() : String { }; let h : Integer64 = G();",
+            "Initializer type 'String' does not match explicit type 'Integer64'");
+}
+
+TEST_F(CompilerFixture, let_type_missing) {
+    verify_error("let a : Q;", "Type 'Q' not found");
+}
+
+TEST_F(CompilerFixture, let_redefinition) {
+    verify_error("let a = 1; let a = 2;", "Identifier 'a' is already in symtab");
+}
+
 TEST_F(CompilerFixture, assignment_type_mismatch_var) {
     verify_error(R"(func f() : Void { let h : Integer64; h = "string"; };)",
             "Left type 'Integer64' of assignment does not match the right "
             "type 'String'");
 }
 
+TEST_F(CompilerFixture, assignment_type_mismatch_module) {
+    verify_error(R"(let h = 1; h = "string";)",
+            "Left type 'Integer64' of assignment does not match the right type 'String'");
+}
+
 TEST_F(CompilerFixture, func_missing) {
     verify_error("func say_hello() : Void { let h = get_hello(); };",
             "Identifier 'get_hello' is not found");
@@ -468,6 +568,18 @@ TEST_F(CompilerFixture, func_call_type_mismatch) {
             " which does not match definition type 'String'");
 }
 
+TEST_F(CompilerFixture, func_call_module) {
+    verify_error("func G(s: String) : Void { }; let b = G();",
+            "Call to function 'G' has wrong number of arguments");
+    verify_error("func G(s: String) : Void { }; let b = G(42);",
+            "Argument 1 in call to function 'G' has type 'Integer64' which does not match "
+            "definition type 'String'");
+}
+
+TEST_F(CompilerFixture, func_call_not_a_function) {
+    verify_error("let a = 1; let b = a();", "Identifier 'a' is not a function");
+}
+
 TEST_F(CompilerFixture, io_print_call_overload_int) {
     verify_ok("import io; func f() : Void { io.print(42); };");
 }
@@ -479,4 +591,158 @@ TEST_F(CompilerFixture, io_print_call_overload_bool) {
 TEST_F(CompilerFixture, io_print_call_overload_custom) {
     verify_error("import io; class C {}; func f() : Void { let c: C; io.print(c); };");
 }
+
+TEST_F(CompilerFixture, compilers_on_threads) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([this, i] {
+            for (int j = 0; j < 16; ++j) {
+                auto value = i * 100 + j;
+                verify_root(FF("let a = {};", value),
+                        FF("Module([Let(n=Id(a), i=Int({}))])", value));
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+TEST_F(CompilerFixture, node_kinds) {
+    Compiler compiler;
+    auto root = compiler.compile_module("func F(a: Integer64) : Integer64 { return a + 1; };");
+    ASSERT_TRUE(isa<ast::Module>(root));
+
+    auto stmt = cast<ast::NodeList>(cast<ast::Module>(root)->get_body())->get_list().front();
+    auto func = dyn_cast<ast::FuncNode>(stmt);
+    ASSERT_TRUE(func);
+    ASSERT_FALSE(dyn_cast<ast::ClassNode>(stmt));
+    ASSERT_FALSE(isa<ast::Identifier>(nullptr));
+
+    auto body = cast<ast::NodeList>(func->get_body());
+    auto describe = [](const auto &node) -> std::string {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_base_of_v<ast::OpBinary, T>) {
+            return "binary";
+        } else if constexpr (std::is_same_v<T, ast::ReturnNode>) {
+            return "return";
+        } else {
+            return "other";
+        }
+    };
+    ASSERT_EQ(ast::visit(*body->get_list().front(), describe), "return");
+    ASSERT_EQ(ast::visit(*func, describe), "other");
+}
+
+TEST_F(CompilerFixture, compiler_reset) {
+    Compiler compiler;
+    const auto &arena = ParseContext::current()->get_arena();
+    std::string code = "func F(a: Integer64) : Integer64 { return a + 1; };";
+
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+
+    compiler.reset();
+    auto prelude = arena.get_count();
+    ASSERT_TRUE(compiler.get_wasm_ctx().body().empty());
+
+    // every compilation after a reset starts from the prelude alone and does the same work
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(compiler.compile_string(code), 0);
+        ASSERT_EQ(compiler.get_wasm_ctx().body().str(), wat);
+        compiler.reset();
+        ASSERT_EQ(arena.get_count(), prelude);
+    }
+
+    ASSERT_NE(compiler.compile_string("func"), 0);
+    compiler.reset();
+    ASSERT_TRUE(compiler.get_error().empty());
+}
+
+TEST_F(CompilerFixture, fold_constants) {
+    Compiler compiler;
+    compiler.set_optimize({.level = 1});
+
+    ASSERT_EQ(compiler.compile_string("func F(a: Integer64) : Integer64 {"
+                                      " let k = 2 * 3 + -1; let d = a; d = d * k;"
+                                      " return d / (k - 5) + k * 10; };"),
+            0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+
+    // k is gone, d is kept since it is assigned to, division by zero is left to run time
+    ASSERT_EQ(wat.find("$k"), std::string::npos);
+    ASSERT_NE(wat.find("(local $d i64)"), std::string::npos);
+    ASSERT_NE(wat.find("  i64.const 5\n  i64.mul\n"), std::string::npos);
+    ASSERT_NE(wat.find("  i64.const 0\n  i64.div_s\n  i64.const 50\n  i64.add\n"),
+            std::string::npos);
+
+    compiler.reset();
+    ASSERT_EQ(compiler.compile_string("func B() : Boolean { return 3 < (4 * 4); };"), 0);
+    ASSERT_NE(compiler.get_wasm_ctx().body().str().find("  i32.const 1\n  return\n"),
+            std::string::npos);
+}
+
+TEST_F(CompilerFixture, eliminate_dead_code) {
+    Compiler compiler;
+    compiler.set_optimize({.level = 1});
+
+    ASSERT_EQ(compiler.compile_string("func D(a: Integer64) : Integer64 {"
+                                      " if (1 > 2) { a = a * 100; } else { a = a + 1; };"
+                                      " while (2 < 1) { a = 0; }; return a; a = 5; };"),
+            0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+    ASSERT_EQ(wat.find("i64.mul"), std::string::npos);
+    ASSERT_NE(wat.find("  i64.const 1\n  i64.add\n"), std::string::npos);
+    ASSERT_EQ(wat.find("i64.const 5"), std::string::npos);
+
+    compiler.reset();
+    compiler.set_optimize({.level = 1, .entry_points = {Symbol::intern("F")}});
+    ASSERT_EQ(compiler.compile_string("func F() : Integer64 { return H(); };"
+                                      "func G() : Integer64 { return 1; };"
+                                      "func H() : Integer64 { return 2; };"),
+            0);
+    wat = compiler.get_wasm_ctx().body().str();
+    ASSERT_NE(wat.find("(func $F"), std::string::npos);
+    ASSERT_EQ(wat.find("(func $G"), std::string::npos);
+    ASSERT_NE(wat.find("(func $H"), std::string::npos);
+}
+
+TEST_F(CompilerFixture, entry_point_missing) {
+    Compiler compiler;
+    std::string code = "func Main() : Integer64 { return 1; };";
+
+    compiler.set_optimize({.level = 1, .entry_points = {Symbol::intern("Mian")}});
+    ASSERT_NE(compiler.compile_string(code), 0);
+    ASSERT_EQ(compiler.get_error(), "Entry point 'Mian' is not a function of the module\n");
+
+    compiler.reset();
+    compiler.set_optimize({.level = 1, .entry_points = {Symbol::intern("Main")}});
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    ASSERT_NE(compiler.get_wasm_ctx().body().str().find("(func $Main"), std::string::npos);
+}
+
+TEST_F(CompilerFixture, inline_functions) {
+    Compiler compiler;
+    compiler.set_optimize({.level = 2, .entry_points = {Symbol::intern("F")}});
+    ASSERT_EQ(compiler.compile_string(
+                      "func Sq(x: Integer64) : Integer64 { return x * x; };"
+                      "func Twice(x: Integer64) : Integer64 { return Sq(x) + Sq(x); };"
+                      "func R(n: Integer64) : Integer64 { return R(n - 1); };"
+                      "func F(a: Integer64) : Integer64 {"
+                      " let b = Twice(a + 1); return b + Sq(3) + R(a); };"),
+            0);
+
+    // only F and R are left
+    auto wat = compiler.get_wasm_ctx().body().str();
+    ASSERT_EQ(wat.find("(func $Sq"), std::string::npos);
+    ASSERT_EQ(wat.find("(func $Twice"), std::string::npos);
+    ASSERT_EQ(wat.find("call $Sq"), std::string::npos);
+    ASSERT_EQ(wat.find("call $Twice"), std::string::npos);
+    ASSERT_NE(wat.find("call $R"), std::string::npos);
+
+    // a + 1 is used four times, it goes into a local of its own; Sq(3) is folded
+    ASSERT_NE(wat.find("(local $x.0 i64)"), std::string::npos);
+    ASSERT_NE(wat.find("  i64.const 9\n"), std::string::npos);
+}
 } // namespace kiraz
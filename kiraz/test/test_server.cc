@@ -0,0 +1,78 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Server.h>
+
+namespace kiraz {
+
+/**
+ * The request protocol of kirazc --server, run over temporary files instead of a socket.
+ */
+struct ServerFixture : public ::testing::Test {
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+/**
+ * @brief serve: Runs the server over the given input and returns what it wrote.
+ */
+static std::string serve(Compiler &compiler, std::string_view input, bool *quit = nullptr) {
+    auto in = std::tmpfile();
+    auto out = std::tmpfile();
+    std::fwrite(input.data(), 1, input.size(), in);
+    std::rewind(in);
+
+    auto retval = server::serve(compiler, Compiler::Output::Wat, {}, in, out);
+    if (quit) {
+        *quit = retval;
+    }
+
+    std::string output(std::ftell(out), '\0');
+    std::rewind(out);
+    output.resize(std::fread(output.data(), 1, output.size(), out));
+    std::fclose(in);
+    std::fclose(out);
+    return output;
+}
+
+TEST_F(ServerFixture, framing) {
+    Compiler compiler;
+    std::string code = "func F() : Integer64 { return 1; };";
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+
+    // two requests in a row, then quit before the last one
+    bool quit = false;
+    auto output = serve(compiler,
+            FF("source {}\n{}source wat O0 {}\n{}quit\nsource 1\nx", code.size(), code, code.size(),
+                    code),
+            &quit);
+    ASSERT_TRUE(quit);
+    auto response = FF("0 {} 0 0\n{}", wat.size(), wat);
+    ASSERT_EQ(output, response + response);
+
+    // the file a request names shows in its diagnostics
+    auto error = FF("missing.ki: {}\n", std::strerror(ENOENT));
+    ASSERT_EQ(serve(compiler, "file 10\nmissing.ki"), FF("2 0 {} 0\n{}", error.size(), error));
+
+    // the session ends at the first request that can not be framed
+    auto malformed = [&](std::string_view input, std::string_view error) {
+        ASSERT_EQ(serve(compiler, input, &quit), FF("1 0 {} 0\n{}", error.size(), error));
+        ASSERT_FALSE(quit);
+    };
+    malformed("source\n", "malformed request: source\n");
+    malformed("source 1x\nx", "malformed request: source 1x\n");
+    malformed("program 1\nx", "malformed request: program 1\n");
+    malformed("source wasm O-1 1\nx", "malformed request: source wasm O-1 1\n");
+    malformed("source 10\nx", "request cut short: 10 bytes expected\n");
+    malformed(FF("source {}\n", server::MaxPayload + 1),
+            FF("request too large: {} bytes, at most {} are accepted\n", server::MaxPayload + 1,
+                    server::MaxPayload));
+    malformed(FF("source 99999999999999999999999\n{}source 1\nx", code),
+            "malformed request: source 99999999999999999999999\n");
+}
+} // namespace kiraz
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Type.h>
+#include <kiraz/wasm/Binary.h>
+
+namespace kiraz {
+
+/**
+ * The canonical type objects of a compiler, which are compared by pointer.
+ */
+struct TypeFixture : public ::testing::Test {
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(TypeFixture, canonical) {
+    Compiler compiler;
+    auto &types = compiler.get_types();
+
+    auto unary = types.get_func({&Type::Integer64}, &Type::Boolean);
+    ASSERT_EQ(unary, types.get_func({&Type::Integer64}, &Type::Boolean));
+    ASSERT_NE(unary, types.get_func({}, &Type::Boolean));
+    ASSERT_EQ(unary->as_string(), "(Integer64) -> Boolean");
+
+    ASSERT_EQ(Type::get_builtin(sym::Integer64), &Type::Integer64);
+    ASSERT_EQ(Type::get_builtin(Symbol::intern("Foo")), nullptr);
+    ASSERT_EQ(wasm::type_of(&Type::Boolean), wasm::ValType::I32);
+    ASSERT_FALSE(wasm::type_of(&Type::Void));
+}
+} // namespace kiraz
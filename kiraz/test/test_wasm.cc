@@ -0,0 +1,218 @@
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <kiraz/Compiler.h>
+#include <kiraz/Node.h>
+#include <kiraz/wasm/Binary.h>
+
+namespace kiraz {
+
+/**
+ * Code generation checks that look at the emitted text or bytes themselves, so they need neither
+ * wabt nor a wasm engine.
+ */
+struct WasmFixture : public ::testing::Test {
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(WasmFixture, binary_output) {
+    Compiler compiler;
+    compiler.set_output(Compiler::Output::Wasm);
+    ASSERT_EQ(compiler.compile_string("func F() : Integer64 { return -1; };"), 0);
+
+    // clang-format off
+    std::vector<uint8_t> expected = {
+        0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, // magic, version
+        0x01, 0x05, 0x01, 0x60, 0x00, 0x01, 0x7e,       // type: () -> i64
+        0x03, 0x02, 0x01, 0x00,                         // function: type 0
+        0x07, 0x05, 0x01, 0x01, 0x46, 0x00, 0x00,       // export: "F" func 0
+        0x0a, 0x0b, 0x01, 0x09, 0x00,                   // code: one body, no locals
+        0x42, 0x00, 0x42, 0x01, 0x7d,                   // 0 - 1
+        0x0f, 0x00, 0x0b,                               // return, unreachable, end
+    };
+    // clang-format on
+    ASSERT_EQ(compiler.get_wasm(), expected);
+}
+
+TEST_F(WasmFixture, text_and_binary) {
+    std::string code = "func G(a: Integer64) : Integer64 { return a; };"
+                       "func F() : Integer64 { let x: Integer64 = G(2); x = x + 1; return x; };";
+
+    // both formats are written from the same instructions, by name and by index
+    Compiler compiler;
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    ASSERT_EQ(compiler.get_wasm_ctx().body().str(),
+            "(module\n"
+            "(func $G (export \"G\") (param $a i64) (result i64)\n"
+            "  local.get $a\n"
+            "  return\n"
+            "  unreachable\n"
+            ")\n"
+            "(func $F (export \"F\") (result i64)\n"
+            "  (local $x i64)\n"
+            "  i64.const 2\n"
+            "  call $G\n"
+            "  local.set $x\n"
+            "  local.get $x\n"
+            "  i64.const 1\n"
+            "  i64.add\n"
+            "  local.set $x\n"
+            "  local.get $x\n"
+            "  return\n"
+            "  unreachable\n"
+            ")\n"
+            ")\n");
+
+    compiler.reset();
+    compiler.set_output(Compiler::Output::Wasm);
+    ASSERT_EQ(compiler.compile_string(code), 0);
+
+    // clang-format off
+    std::vector<uint8_t> body = {
+        0x01, 0x01, 0x7e,                         // one i64 local
+        0x42, 0x02, 0x10, 0x00, 0x21, 0x00,       // x = G(2)
+        0x20, 0x00, 0x42, 0x01, 0x7c, 0x21, 0x00, // x = x + 1
+        0x20, 0x00, 0x0f, 0x00, 0x0b,             // return x, unreachable, end
+    };
+    // clang-format on
+    const auto &wasm = compiler.get_wasm();
+    ASSERT_GT(wasm.size(), body.size());
+    ASSERT_TRUE(std::equal(body.begin(), body.end(), wasm.end() - body.size()));
+}
+
+TEST_F(WasmFixture, module_import) {
+    std::string code = "import io; func F() : Integer64 { return 1; };";
+
+    Compiler compiler;
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+    ASSERT_NE(wat.find("(func $F"), std::string::npos);
+    ASSERT_EQ(wat.find("io"), std::string::npos);
+
+    compiler.reset();
+    compiler.set_output(Compiler::Output::Wasm);
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    ASSERT_FALSE(compiler.get_wasm().empty());
+}
+
+TEST_F(WasmFixture, share_locals) {
+    Compiler compiler;
+    std::string code = "func F(a: Integer64, b: Integer64) : Boolean {"
+                       " let g = a < b; let c = a * b; let d = c + a;"
+                       " let e: Integer64; e = d - b; let f = e < b; return f; };";
+
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    auto wat = compiler.get_wasm_ctx().body().str();
+    ASSERT_NE(wat.find("(local $d i64)"), std::string::npos);
+    ASSERT_NE(wat.find("(local $f i32)"), std::string::npos);
+
+    // d takes the slot of c, whose last use is its initializer, and f that of g; e is read before
+    // it is stored to, in principle, so it gets a slot of its own
+    compiler.reset();
+    compiler.set_optimize({.level = 1});
+    ASSERT_EQ(compiler.compile_string(code), 0);
+    wat = compiler.get_wasm_ctx().body().str();
+    ASSERT_NE(wat.find("(result i32)\n  (local $c i64)\n  (local $e i64)\n  (local $g i32)\n"),
+            std::string::npos);
+    ASSERT_EQ(wat.find("$d"), std::string::npos);
+    ASSERT_EQ(wat.find("$f"), std::string::npos);
+    ASSERT_NE(wat.find("  i64.add\n  local.tee $c\n"), std::string::npos);
+    ASSERT_NE(wat.find("  i64.lt_s\n  local.tee $g\n  return\n"), std::string::npos);
+}
+
+TEST_F(WasmFixture, peephole) {
+    using wasm::Op;
+    auto x = Symbol::intern("x");
+
+    wasm::Code code;
+    code.emit(Op::LocalGet, 0, x);
+    code.emit(Op::I64Const, 0);
+    code.emit(Op::I64Add);
+    code.emit(Op::LocalSet, 0, x);
+    code.emit(Op::LocalGet, 0, x);
+    code.emit(Op::LocalGet, 0, x);
+    code.emit(Op::I64Const, 2);
+    code.emit(Op::I64LtS);
+    code.emit(Op::Drop);
+    code.emit(Op::I64Const, 1);
+    code.emit(Op::I64Mul);
+    code.emit(Op::I32Const, 1);
+    code.emit(Op::I64ExtendI32S);
+    code.emit(Op::I32WrapI64);
+    code.emit(Op::Drop);
+    code.emit(Op::LocalGet, 0, x);
+    code.emit(Op::I64Const, 0);
+    code.emit(Op::I64DivS);
+    code.emit(Op::Drop);
+    code.emit(Op::I64Const, 3);
+    code.emit(Op::LocalTee, 0, x);
+    code.emit(Op::Drop);
+    code.emit(Op::Return);
+    code.emit(Op::Unreachable);
+    ASSERT_EQ(code.peephole(), 15);
+
+    // a division can trap, it stays even though its value is dropped
+    fmt::memory_buffer out;
+    code.write_text(out);
+    ASSERT_EQ(fmt::to_string(out),
+            "  local.get $x\n"
+            "  local.tee $x\n"
+            "  local.get $x\n"
+            "  i64.const 0\n"
+            "  i64.div_s\n"
+            "  drop\n"
+            "  i64.const 3\n"
+            "  local.set $x\n"
+            "  return\n");
+}
+
+TEST_F(WasmFixture, release_local_once) {
+    auto a = Symbol::intern("a");
+    auto x = Symbol::intern("x");
+    auto y = Symbol::intern("y");
+    auto z = Symbol::intern("z");
+
+    // two lets of the same name die together and release the same index twice; the index must
+    // still go to only one of the locals after them, and the parameter must not be given away
+    wasm::Locals locals;
+    locals.add_param(a, &Type::Integer64);
+    auto index_x = locals.add_local(x, &Type::Integer64);
+    locals.release(x);
+    locals.release(x);
+    locals.release(a);
+    auto index_y = locals.add_local(y, &Type::Integer64, true);
+    auto index_z = locals.add_local(z, &Type::Integer64, true);
+    ASSERT_EQ(index_y, index_x);
+    ASSERT_NE(index_z, index_y);
+    ASSERT_NE(index_z, 0u);
+
+    // the text format calls a reused index by the name of the local that first took it
+    ASSERT_EQ(locals.get_slot(index_y), x);
+    ASSERT_EQ(locals.get_slot(index_z), z);
+    ASSERT_EQ(locals.get_declarations(), (std::vector<uint32_t>{index_x, index_z}));
+}
+
+TEST_F(WasmFixture, wasm_context_nesting) {
+    WasmContext ctx;
+    ctx.body() << "(module\n";
+    for (int i = 0; i < 3; ++i) {
+        ctx.push();
+        ctx.locals() << FF("(local $l{} i64)\n", i);
+        ctx.body() << FF("(body {})\n", i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        ctx.pop();
+    }
+    ctx.body() << ")\n";
+
+    ASSERT_EQ(ctx.body().str(),
+            "(module\n"
+            "(local $l0 i64)\n(body 0)\n"
+            "(local $l1 i64)\n(body 1)\n"
+            "(local $l2 i64)\n(body 2)\n"
+            ")\n");
+}
+} // namespace kiraz
@@ -2,6 +2,39 @@
 #include "Literal.h"
 
 namespace token {
-    Integer::~Integer() {}
-    Identifier::~Identifier() {}
+std::string StringLiteral::get_value() const {
+    auto raw = get_raw();
+    std::string retval;
+    retval.reserve(raw.size());
+
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] == '\\' && i + 1 < raw.size()) {
+            switch (raw[i + 1]) {
+            case 'n':
+                retval += '\n';
+                ++i;
+                break;
+            case 't':
+                retval += '\t';
+                ++i;
+                break;
+            case '\\':
+                retval += '\\';
+                ++i;
+                break;
+            case '"':
+                retval += '"';
+                ++i;
+                break;
+            default:
+                break;
+            }
+        }
+        else {
+            retval += raw[i];
+        }
+    }
+
+    return retval;
 }
+} // namespace token
@@ -1,63 +1,65 @@
 #ifndef KIRAZ_TOKEN_LITERAL_H
 #define KIRAZ_TOKEN_LITERAL_H
 
+#include <cassert>
+#include <string>
+
 #include <kiraz/Token.h>
 
 namespace token {
 
-class Integer : public Token {
-public: 
-    Integer(int64_t base, std::string_view value) 
-        : Token(L_INTEGER), m_base(base), m_value(value) {}
-    virtual ~Integer();
-
-    std::string as_string() const override {return fmt::format("Int({}, {})", m_base, m_value); }
+/*
+ * Typed views over literal tokens. They do not own anything; the text they return points into
+ * the lexer buffer, just like Token::get_text().
+ */
 
-    void print() {fmt::print("{}\n", as_string()); }
+class Integer {
+public:
+    explicit Integer(const Token &t) : m_token(t) { assert(t.get_id() == L_INTEGER); }
 
-    static int colno;
+    auto get_base() const { return 10; }
+    auto get_value() const { return m_token.get_text(); }
 
-    auto get_base() const {return m_base; }
-    auto get_value() const {return m_value; }
+    std::string as_string() const { return fmt::format("Int({}, {})", get_base(), get_value()); }
 
 private:
-    int m_id;
-    int64_t m_base;
-    std::string m_value;
+    Token m_token;
 };
 
-class Identifier : public Token {
+class Identifier {
 public:
-    Identifier(std::string_view name)
-        : Token(IDENTIFIER), m_name(name) {}
-    virtual ~Identifier();
+    explicit Identifier(const Token &t) : m_token(t) { assert(t.get_id() == IDENTIFIER); }
 
-    std::string as_string() const override { 
-        return fmt::format("Id({})", m_name); }
+    auto get_name() const { return m_token.get_symbol().str(); }
+    auto get_symbol() const { return m_token.get_symbol(); }
 
-    void print() { 
-        fmt::print("{}\n", as_string()); }
-
-    auto get_name() const { return m_name; }
+    std::string as_string() const { return fmt::format("Id({})", get_name()); }
 
 private:
-    std::string m_name;
+    Token m_token;
 };
 
-class StringLiteral : public Token {
+class StringLiteral {
 public:
-    StringLiteral(std::string_view value) : Token(L_STRING), m_value(value) {}
+    explicit StringLiteral(const Token &t) : m_token(t) { assert(t.get_id() == L_STRING); }
+
+    std::string as_string() const { return fmt::format("Str({})", get_value()); }
 
-    std::string as_string() const override {
-        return fmt::format("Str({})", m_value);
-    }
+    /**
+     * @brief get_raw: The literal as written in the source, without the quotes and with the
+     *        escape sequences intact.
+     */
+    auto get_raw() const { return m_token.get_text(); }
 
-    auto get_value() const { return m_value; }
+    /**
+     * @brief get_value: The literal with escape sequences resolved.
+     */
+    std::string get_value() const;
 
 private:
-    std::string m_value;
+    Token m_token;
 };
 
-}
+} // namespace token
 
 #endif // KIRAZ_TOKEN_LITERAL_H
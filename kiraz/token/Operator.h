@@ -4,120 +4,55 @@
 #include <kiraz/Token.h>
 
 namespace token {
-class Operator : public Token {
-public:
-    Operator(int type) : Token(type) {}
-};
-
-class OpPlus : public Operator {
-public:
-    OpPlus() : Operator(OP_PLUS) {}
-    std::string as_string() const override { return "OP_PLUS"; }
-};
-
-class OpMinus : public Operator {
-public:
-    OpMinus() : Operator(OP_MINUS) {}
-    std::string as_string() const override { return "OP_MINUS"; }
-};
-
-class OpMult : public Operator {
-public:
-    OpMult() : Operator(OP_MULT) {}
-    std::string as_string() const override { return "OP_MULT"; }
-};
-
-class OpDivF : public Operator {
-public:
-    OpDivF() : Operator(OP_DIVF) {}
-    std::string as_string() const override { return "OP_DIVF"; }
-};
-
-class OpLparen : public Operator {
-public:
-    OpLparen() : Operator(OP_LPAREN) {}
-    std::string as_string() const override { return "OP_LPAREN"; }
-};
-
-class OpRparen : public Operator {
-public:
-    OpRparen() : Operator(OP_RPAREN) {}
-    std::string as_string() const override { return "OP_RPAREN"; }
-};
-
-class OpComma : public Operator {
-public:
-    OpComma() : Operator(OP_COMMA) {}
-    std::string as_string() const override { return "OP_COMMA"; }
-};
-
-class OpScolon : public Operator {
-public:
-    OpScolon() : Operator(OP_SCOLON) {}
-    std::string as_string() const override { return "OP_SCOLON"; }
-};
-
-class OpColon : public Operator {
-public:
-    OpColon() : Operator(OP_COLON) {}
-    std::string as_string() const override { return "OP_COLON"; }
-};
-
-class OpLbrace : public Operator {
-public:
-    OpLbrace() : Operator(OP_LBRACE) {}
-    std::string as_string() const override { return "OP_LBRACE"; }
-};
-
-class OpRbrace : public Operator {
-public:
-    OpRbrace() : Operator(OP_RBRACE) {}
-    std::string as_string() const override { return "OP_RBRACE"; }
-};
-
-class OpAssign : public Operator {
-public:
-    OpAssign() : Operator(OP_ASSIGN) {}
-    std::string as_string() const override { return "OP_ASSIGN"; }
-};
-
-class OpEq : public Operator {
-public:
-    OpEq() : Operator(OP_EQ) {}
-    std::string as_string() const override { return "OP_EQ"; }
-};
-
-class OpGt : public Operator {
-public:
-    OpGt() : Operator(OP_GT) {}
-    std::string as_string() const override { return "OP_GT"; }
-};
-
-class OpGe : public Operator {
-public:
-    OpGe() : Operator(OP_GE) {}
-    std::string as_string() const override { return "OP_GE"; }
-};
-
-class OpLt : public Operator {
-public:
-    OpLt() : Operator(OP_LT) {}
-    std::string as_string() const override { return "OP_LT"; }
-};
-
-class OpLe : public Operator {
-public:
-    OpLe() : Operator(OP_LE) {}
-    std::string as_string() const override { return "OP_LE"; }
-};
-
-class OpDot : public Operator {
-public:
-    OpDot() : Operator(OP_DOT) {}
-    std::string as_string() const override { return "OP_DOT"; }
-};
-
 
+/**
+ * @brief operator_name: Returns the printable name of the given operator token id, or nullptr if
+ *        the id does not belong to an operator. Operator tokens carry no payload, so this table is
+ *        all there is to them.
+ */
+constexpr const char *operator_name(int id) {
+    switch (id) {
+    case OP_PLUS:
+        return "OP_PLUS";
+    case OP_MINUS:
+        return "OP_MINUS";
+    case OP_MULT:
+        return "OP_MULT";
+    case OP_DIVF:
+        return "OP_DIVF";
+    case OP_LPAREN:
+        return "OP_LPAREN";
+    case OP_RPAREN:
+        return "OP_RPAREN";
+    case OP_COMMA:
+        return "OP_COMMA";
+    case OP_SCOLON:
+        return "OP_SCOLON";
+    case OP_COLON:
+        return "OP_COLON";
+    case OP_LBRACE:
+        return "OP_LBRACE";
+    case OP_RBRACE:
+        return "OP_RBRACE";
+    case OP_ASSIGN:
+        return "OP_ASSIGN";
+    case OP_EQ:
+        return "OP_EQ";
+    case OP_GT:
+        return "OP_GT";
+    case OP_GE:
+        return "OP_GE";
+    case OP_LT:
+        return "OP_LT";
+    case OP_LE:
+        return "OP_LE";
+    case OP_DOT:
+        return "OP_DOT";
+    default:
+        return nullptr;
+    }
 }
 
+} // namespace token
+
 #endif
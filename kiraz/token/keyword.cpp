@@ -1 +0,0 @@
-#include <kiraz/token/keyword.h>
\ No newline at end of file
@@ -5,63 +5,33 @@
 
 namespace token {
 
-class Keyword : public Token {
-public:
-    Keyword(int type) : Token(type) {}
-    virtual ~Keyword() {}
-};
-
-
-class KwLet : public Keyword {
-public:
-    KwLet() : Keyword(KW_LET) {}
-    std::string as_string() const override { return "KW_LET"; }
-};
-
-
-class KwFunc : public Keyword {
-public:
-    KwFunc() : Keyword(KW_FUNC) {}
-    std::string as_string() const override { return "KW_FUNC"; }
-};
-
-class KwIf : public Keyword {
-public:
-    KwIf() : Keyword(KW_IF) {}
-    std::string as_string() const override { return "KW_IF"; }
-};
-
-class KwElse : public Keyword {
-public:
-    KwElse() : Keyword(KW_ELSE) {}
-    std::string as_string() const override { return "KW_ELSE"; }
-};
-
-class KwWhile : public Keyword {
-public:
-    KwWhile() : Keyword(KW_WHILE) {}
-    std::string as_string() const override { return "KW_WHILE"; }
-};
-
-class KwImport : public Keyword {
-public:
-    KwImport() : Keyword(KW_IMPORT) {}
-    std::string as_string() const override { return "KW_IMPORT"; }
-};
-
-class KwClass : public Keyword {
-public:
-    KwClass() : Keyword(KW_CLASS) {}
-    std::string as_string() const override { return "KW_CLASS"; }
-};
-
-class KwReturn : public Keyword {
-public:
-    KwReturn() : Keyword(KW_RETURN) {}
-    std::string as_string() const override { return "KW_RETURN"; }
-};
-
-
+/**
+ * @brief keyword_name: Returns the printable name of the given keyword token id, or nullptr if
+ *        the id does not belong to a keyword.
+ */
+constexpr const char *keyword_name(int id) {
+    switch (id) {
+    case KW_LET:
+        return "KW_LET";
+    case KW_FUNC:
+        return "KW_FUNC";
+    case KW_IF:
+        return "KW_IF";
+    case KW_ELSE:
+        return "KW_ELSE";
+    case KW_WHILE:
+        return "KW_WHILE";
+    case KW_IMPORT:
+        return "KW_IMPORT";
+    case KW_CLASS:
+        return "KW_CLASS";
+    case KW_RETURN:
+        return "KW_RETURN";
+    default:
+        return nullptr;
+    }
 }
 
+} // namespace token
+
 #endif // KIRAZ_TOKEN_KEYWORD_H
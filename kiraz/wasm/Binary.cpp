@@ -0,0 +1,538 @@
+
+#include "Binary.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace wasm {
+
+namespace section {
+enum : uint8_t {
+    Type = 1,
+    Import = 2,
+    Function = 3,
+    Export = 7,
+    Code = 10,
+};
+}
+
+std::optional<ValType> type_of(const Type *type) {
+    switch (type->get_kind()) {
+    case Type::Kind::Void:
+        return std::nullopt;
+    case Type::Kind::Boolean:
+        return ValType::I32;
+    case Type::Kind::Integer64:
+        return ValType::I64;
+    default:
+        throw std::runtime_error(fmt::format("Unsupported type '{}'", *type));
+    }
+}
+
+FuncType signature_of(const Type *func) {
+    assert(func->get_kind() == Type::Kind::Func);
+
+    FuncType retval;
+    for (auto param : func->get_params()) {
+        auto type = type_of(param);
+        if (! type) {
+            throw std::runtime_error(fmt::format("Unsupported parameter type '{}'", *param));
+        }
+        retval.params.push_back(*type);
+    }
+
+    if (auto result = type_of(func->get_result())) {
+        retval.results.push_back(*result);
+    }
+    return retval;
+}
+
+const char *type_name(ValType type) {
+    switch (type) {
+    case ValType::I32:
+        return "i32";
+    case ValType::I64:
+        return "i64";
+    }
+    return "";
+}
+
+const char *op_name(Op op) {
+    switch (op) {
+    case Op::Unreachable:
+        return "unreachable";
+    case Op::Nop:
+        return "nop";
+    case Op::Block:
+        return "block";
+    case Op::Loop:
+        return "loop";
+    case Op::If:
+        return "if";
+    case Op::Else:
+        return "else";
+    case Op::End:
+        return "end";
+    case Op::Br:
+        return "br";
+    case Op::BrIf:
+        return "br_if";
+    case Op::Return:
+        return "return";
+    case Op::Call:
+        return "call";
+    case Op::Drop:
+        return "drop";
+    case Op::LocalGet:
+        return "local.get";
+    case Op::LocalSet:
+        return "local.set";
+    case Op::LocalTee:
+        return "local.tee";
+    case Op::I32Const:
+        return "i32.const";
+    case Op::I64Const:
+        return "i64.const";
+    case Op::I64Eqz:
+        return "i64.eqz";
+    case Op::I64Eq:
+        return "i64.eq";
+    case Op::I64Ne:
+        return "i64.ne";
+    case Op::I64LtS:
+        return "i64.lt_s";
+    case Op::I64GtS:
+        return "i64.gt_s";
+    case Op::I64LeS:
+        return "i64.le_s";
+    case Op::I64GeS:
+        return "i64.ge_s";
+    case Op::I32Add:
+        return "i32.add";
+    case Op::I32Sub:
+        return "i32.sub";
+    case Op::I32Mul:
+        return "i32.mul";
+    case Op::I64Add:
+        return "i64.add";
+    case Op::I64Sub:
+        return "i64.sub";
+    case Op::I64Mul:
+        return "i64.mul";
+    case Op::I64DivS:
+        return "i64.div_s";
+    case Op::I32WrapI64:
+        return "i32.wrap_i64";
+    case Op::I64ExtendI32S:
+        return "i64.extend_i32_s";
+    case Op::I64ExtendI32U:
+        return "i64.extend_i32_u";
+    }
+    return "";
+}
+
+void ByteBuffer::uleb(uint64_t v) {
+    do {
+        uint8_t byte = v & 0x7f;
+        v >>= 7;
+        if (v != 0) {
+            byte |= 0x80;
+        }
+        u8(byte);
+    } while (v != 0);
+}
+
+void ByteBuffer::sleb(int64_t v) {
+    for (;;) {
+        uint8_t byte = v & 0x7f;
+        v >>= 7; // arithmetic shift, keeps the sign
+        bool done = (v == 0 && ! (byte & 0x40)) || (v == -1 && (byte & 0x40));
+        if (! done) {
+            byte |= 0x80;
+        }
+        u8(byte);
+        if (done) {
+            return;
+        }
+    }
+}
+
+void ByteBuffer::name(std::string_view v) {
+    uleb(v.size());
+    append(reinterpret_cast<const uint8_t *>(v.data()), v.size());
+}
+
+void ByteBuffer::instr(const Instr &instr) {
+    op(instr.op);
+    switch (instr.op) {
+    case Op::Block:
+    case Op::Loop:
+    case Op::If:
+        // no result
+        u8(0x40);
+        break;
+    case Op::Br:
+    case Op::BrIf:
+    case Op::Call:
+    case Op::LocalGet:
+    case Op::LocalSet:
+    case Op::LocalTee:
+        uleb(instr.imm);
+        break;
+    case Op::I32Const:
+    case Op::I64Const:
+        sleb(instr.imm);
+        break;
+    default:
+        break;
+    }
+}
+
+void Code::write_text(fmt::memory_buffer &out) const {
+    auto it = std::back_inserter(out);
+    for (const auto &instr : m_instrs) {
+        switch (instr.op) {
+        case Op::Call:
+        case Op::LocalGet:
+        case Op::LocalSet:
+        case Op::LocalTee:
+            fmt::format_to(it, "  {} ${}\n", op_name(instr.op), instr.name);
+            break;
+        case Op::Br:
+        case Op::BrIf:
+        case Op::I32Const:
+        case Op::I64Const:
+            fmt::format_to(it, "  {} {}\n", op_name(instr.op), instr.imm);
+            break;
+        default:
+            fmt::format_to(it, "  {}\n", op_name(instr.op));
+        }
+    }
+}
+
+uint32_t Locals::add_param(Symbol name, const Type *type) {
+    assert(m_params == m_values.size());
+    auto retval = add_index(name, type);
+    ++m_params;
+    return retval;
+}
+
+uint32_t Locals::add_local(Symbol name, const Type *type, bool reuse) {
+    if (! reuse) {
+        return add_index(name, type);
+    }
+
+    auto value = type_of(type);
+    auto free = std::find_if(m_free.begin(), m_free.end(),
+            [&](uint32_t index) { return value && m_values[index] == *value; });
+    if (free == m_free.end()) {
+        return add_index(name, type);
+    }
+
+    auto retval = *free;
+    m_free.erase(free);
+    m_types[retval] = type;
+    m_names[name] = retval;
+    return retval;
+}
+
+uint32_t Locals::add_index(Symbol name, const Type *type) {
+    auto value = type_of(type);
+    if (! value) {
+        throw std::runtime_error(fmt::format("Local '{}' can not have type '{}'", name, *type));
+    }
+
+    uint32_t retval = m_values.size();
+    m_values.push_back(*value);
+    m_types.push_back(type);
+    m_slots.push_back(name);
+    m_names[name] = retval;
+    return retval;
+}
+
+void Locals::release(Symbol name) {
+    auto index = find(name);
+    if (! index || *index < m_params) {
+        return;
+    }
+
+    // two lets of the same name release the same index
+    if (std::find(m_free.begin(), m_free.end(), *index) == m_free.end()) {
+        m_free.push_back(*index);
+    }
+}
+
+std::optional<uint32_t> Locals::find(Symbol name) const {
+    if (auto iter = m_names.find(name); iter != m_names.end()) {
+        return iter->second;
+    }
+    return std::nullopt;
+}
+
+std::vector<uint32_t> Locals::get_declarations() const {
+    std::vector<uint32_t> retval(m_values.size() - m_params);
+    std::iota(retval.begin(), retval.end(), m_params);
+    std::stable_sort(retval.begin(), retval.end(),
+            [&](uint32_t a, uint32_t b) { return m_values[a] < m_values[b]; });
+    return retval;
+}
+
+FunctionBuilder::FunctionBuilder(uint32_t index, const Type *type)
+        : m_index(index), m_type(signature_of(type)), m_decl(type), m_result(type->get_result()) {}
+
+uint32_t FunctionBuilder::add_param(Symbol name) {
+    auto index = m_locals.get_param_count();
+    assert(index < m_type.params.size());
+    return m_locals.add_param(name, m_decl->get_params()[index]);
+}
+
+void FunctionBuilder::encode(ByteBuffer &out) const {
+    ByteBuffer body;
+
+    // locals are declared as runs of the same type, as few as there can be once they are sorted
+    auto params = m_type.params.size();
+    assert(m_locals.get_param_count() == params);
+    auto order = m_locals.get_declarations();
+    std::vector<std::pair<uint32_t, ValType>> runs;
+    std::vector<uint32_t> renumbered(order.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        auto type = m_locals.get_value_type(order[i]);
+        if (runs.empty() || runs.back().second != type) {
+            runs.emplace_back(0, type);
+        }
+        ++runs.back().first;
+        renumbered[order[i] - params] = params + i;
+    }
+
+    body.uleb(runs.size());
+    for (auto [count, type] : runs) {
+        body.uleb(count);
+        body.type(type);
+    }
+
+    for (auto instr : m_code.instrs()) {
+        bool local = instr.op == Op::LocalGet || instr.op == Op::LocalSet
+                || instr.op == Op::LocalTee;
+        if (local && uint64_t(instr.imm) >= params) {
+            instr.imm = renumbered[instr.imm - params];
+        }
+        body.instr(instr);
+    }
+    body.op(Op::End);
+
+    out.uleb(body.size());
+    out.append(body);
+}
+
+void FunctionBuilder::write_text(fmt::memory_buffer &out) const {
+    auto it = std::back_inserter(out);
+    for (uint32_t i = 0; i < m_type.params.size(); ++i) {
+        fmt::format_to(it, " (param ${} {})", m_locals.get_slot(i), type_name(m_type.params[i]));
+    }
+    for (auto result : m_type.results) {
+        fmt::format_to(it, " (result {})", type_name(result));
+    }
+    fmt::format_to(it, "\n");
+
+    // declarations of the same type form a single run in the binary format
+    for (auto index : m_locals.get_declarations()) {
+        fmt::format_to(it, "  (local ${} {})\n", m_locals.get_slot(index),
+                type_name(m_locals.get_value_type(index)));
+    }
+
+    m_code.write_text(out);
+    fmt::format_to(it, ")\n");
+}
+
+uint32_t ModuleBuilder::add_type(const FuncType &type) {
+    for (uint32_t i = 0; i < m_types.size(); ++i) {
+        if (m_types[i] == type) {
+            return i;
+        }
+    }
+    m_types.push_back(type);
+    return m_types.size() - 1;
+}
+
+uint32_t ModuleBuilder::add_import(
+        std::string_view module, std::string_view name, const FuncType &type) {
+    assert(m_functions.empty());
+    m_imports.push_back({std::string(module), std::string(name), add_type(type)});
+    return m_imports.size() - 1;
+}
+
+uint32_t ModuleBuilder::declare_function(Symbol name, const Type *type) {
+    m_functions.push_back(add_type(signature_of(type)));
+    m_decls.push_back(type);
+    m_decl_names.push_back(name);
+    m_bodies.emplace_back();
+    uint32_t retval = m_imports.size() + m_functions.size() - 1;
+    m_names[name] = retval;
+    return retval;
+}
+
+std::optional<uint32_t> ModuleBuilder::find_function(Symbol name) const {
+    if (auto iter = m_names.find(name); iter != m_names.end()) {
+        return iter->second;
+    }
+    return std::nullopt;
+}
+
+const FuncType &ModuleBuilder::get_function_type(uint32_t index) const {
+    if (index < m_imports.size()) {
+        return m_types[m_imports[index].type];
+    }
+    return m_types[m_functions.at(index - m_imports.size())];
+}
+
+const Type *ModuleBuilder::get_function_decl(uint32_t index) const {
+    if (index < m_imports.size()) {
+        return nullptr;
+    }
+    return m_decls.at(index - m_imports.size());
+}
+
+FunctionBuilder &ModuleBuilder::begin_function(uint32_t index) {
+    assert(! m_current);
+    assert(index >= m_imports.size());
+    auto &body = m_bodies.at(index - m_imports.size());
+    assert(! body);
+    body.emplace(index, get_function_decl(index));
+    m_current = &*body;
+    return *m_current;
+}
+
+void ModuleBuilder::end_function() {
+    assert(m_current);
+    if (m_peephole) {
+        m_current->code().peephole();
+    }
+    m_current = nullptr;
+}
+
+FunctionBuilder &ModuleBuilder::current() {
+    if (! m_current) {
+        throw std::runtime_error("Code outside of a function");
+    }
+    return *m_current;
+}
+
+void ModuleBuilder::add_export(std::string_view name, ExternalKind kind, uint32_t index) {
+    m_exports.push_back({std::string(name), kind, index});
+}
+
+void ModuleBuilder::add_section(ByteBuffer &out, uint8_t id, const ByteBuffer &content) const {
+    out.u8(id);
+    out.uleb(content.size());
+    out.append(content);
+}
+
+std::vector<uint8_t> ModuleBuilder::encode() const {
+    ByteBuffer out;
+    static constexpr uint8_t header[] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+    out.append(header, sizeof(header));
+
+    if (! m_types.empty()) {
+        ByteBuffer types;
+        types.uleb(m_types.size());
+        for (const auto &type : m_types) {
+            types.u8(0x60);
+            types.uleb(type.params.size());
+            for (auto p : type.params) {
+                types.type(p);
+            }
+            types.uleb(type.results.size());
+            for (auto r : type.results) {
+                types.type(r);
+            }
+        }
+        add_section(out, section::Type, types);
+    }
+
+    if (! m_imports.empty()) {
+        ByteBuffer imports;
+        imports.uleb(m_imports.size());
+        for (const auto &import : m_imports) {
+            imports.name(import.module);
+            imports.name(import.name);
+            imports.u8(uint8_t(ExternalKind::Func));
+            imports.uleb(import.type);
+        }
+        add_section(out, section::Import, imports);
+    }
+
+    if (! m_functions.empty()) {
+        ByteBuffer functions;
+        functions.uleb(m_functions.size());
+        for (auto type : m_functions) {
+            functions.uleb(type);
+        }
+        add_section(out, section::Function, functions);
+    }
+
+    if (! m_exports.empty()) {
+        ByteBuffer exports;
+        exports.uleb(m_exports.size());
+        for (const auto &exp : m_exports) {
+            exports.name(exp.name);
+            exports.u8(uint8_t(exp.kind));
+            exports.uleb(exp.index);
+        }
+        add_section(out, section::Export, exports);
+    }
+
+    if (! m_functions.empty()) {
+        ByteBuffer code;
+        code.uleb(m_bodies.size());
+        for (uint32_t i = 0; i < m_bodies.size(); ++i) {
+            if (! m_bodies[i]) {
+                throw std::runtime_error(
+                        fmt::format("Function {} has no body", m_imports.size() + i));
+            }
+            m_bodies[i]->encode(code);
+        }
+        add_section(out, section::Code, code);
+    }
+
+    return out.data();
+}
+
+void ModuleBuilder::write_text(fmt::memory_buffer &out) const {
+    auto it = std::back_inserter(out);
+    fmt::format_to(it, "(module\n");
+    for (const auto &import : m_imports) {
+        fmt::format_to(it, "(import \"{}\" \"{}\" (func ${}", import.module, import.name,
+                import.name);
+        const auto &type = m_types[import.type];
+        for (auto param : type.params) {
+            fmt::format_to(it, " (param {})", type_name(param));
+        }
+        for (auto result : type.results) {
+            fmt::format_to(it, " (result {})", type_name(result));
+        }
+        fmt::format_to(it, "))\n");
+    }
+
+    for (uint32_t i = 0; i < m_bodies.size(); ++i) {
+        uint32_t index = m_imports.size() + i;
+        if (! m_bodies[i]) {
+            throw std::runtime_error(fmt::format("Function {} has no body", index));
+        }
+
+        fmt::format_to(it, "(func ${}", m_decl_names[i]);
+        for (const auto &exp : m_exports) {
+            if (exp.kind == ExternalKind::Func && exp.index == index) {
+                fmt::format_to(it, " (export \"{}\")", exp.name);
+            }
+        }
+        m_bodies[i]->write_text(out);
+    }
+    fmt::format_to(it, ")\n");
+}
+
+} // namespace wasm
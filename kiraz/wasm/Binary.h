@@ -0,0 +1,359 @@
+#ifndef KIRAZ_WASM_BINARY_H
+#define KIRAZ_WASM_BINARY_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <kiraz/Symbol.h>
+#include <kiraz/Type.h>
+
+/**
+ * Encoder for the WebAssembly binary format. Code generation emits instructions into function
+ * bodies that are assembled into a module, so no text has to be produced and parsed again on the
+ * way to a .wasm file. The same module can also be written in the text format instead.
+ */
+namespace wasm {
+
+enum class ValType : uint8_t {
+    I32 = 0x7f,
+    I64 = 0x7e,
+};
+
+enum class ExternalKind : uint8_t {
+    Func = 0x00,
+    Memory = 0x02,
+};
+
+enum class Op : uint8_t {
+    Unreachable = 0x00,
+    Nop = 0x01,
+    Block = 0x02,
+    Loop = 0x03,
+    If = 0x04,
+    Else = 0x05,
+    End = 0x0b,
+    Br = 0x0c,
+    BrIf = 0x0d,
+    Return = 0x0f,
+    Call = 0x10,
+    Drop = 0x1a,
+    LocalGet = 0x20,
+    LocalSet = 0x21,
+    LocalTee = 0x22,
+    I32Const = 0x41,
+    I64Const = 0x42,
+    I64Eqz = 0x50,
+    I64Eq = 0x51,
+    I64Ne = 0x52,
+    I64LtS = 0x53,
+    I64GtS = 0x55,
+    I64LeS = 0x57,
+    I64GeS = 0x59,
+    I32Add = 0x6a,
+    I32Sub = 0x6b,
+    I32Mul = 0x6c,
+    I64Add = 0x7c,
+    I64Sub = 0x7d,
+    I64Mul = 0x7e,
+    I64DivS = 0x7f,
+    I32WrapI64 = 0xa7,
+    I64ExtendI32S = 0xac,
+    I64ExtendI32U = 0xad,
+};
+
+struct FuncType {
+    std::vector<ValType> params;
+    std::vector<ValType> results;
+
+    bool operator==(const FuncType &) const = default;
+};
+
+/**
+ * @brief type_of: The value type a Kiraz type is represented with, none for Void.
+ * @throw std::runtime_error for types that have no representation yet.
+ */
+std::optional<ValType> type_of(const Type *type);
+
+/**
+ * @brief signature_of: The wasm signature of a Kiraz function type.
+ */
+FuncType signature_of(const Type *func);
+
+/**
+ * @brief type_name: Name of the given type in the text format.
+ */
+const char *type_name(ValType type);
+
+/**
+ * @brief op_name: Name of the given instruction in the text format.
+ */
+const char *op_name(Op op);
+
+/**
+ * @brief Instr: An instruction and its immediate, if it has one. Locals and functions are referred
+ *        to by index in the binary format and by name in the text format; an instruction carries
+ *        both, so that the code it is part of can be written in either.
+ */
+struct Instr {
+    Op op;
+    int64_t imm = 0;
+    Symbol name;
+
+    bool operator==(const Instr &) const = default;
+};
+
+/**
+ * @brief ByteBuffer: Growable byte vector with writers for the encodings the binary format uses.
+ */
+class ByteBuffer {
+public:
+    void u8(uint8_t v) { m_data.push_back(v); }
+    void op(Op op) { u8(uint8_t(op)); }
+    void type(ValType type) { u8(uint8_t(type)); }
+
+    /**
+     * @brief uleb, sleb: Unsigned and signed LEB128.
+     */
+    void uleb(uint64_t v);
+    void sleb(int64_t v);
+
+    /**
+     * @brief name: Length prefixed UTF-8 string.
+     */
+    void name(std::string_view v);
+
+    /**
+     * @brief instr: An instruction followed by its immediate.
+     */
+    void instr(const Instr &instr);
+
+    void append(const ByteBuffer &other) { append(other.m_data.data(), other.m_data.size()); }
+    void append(const uint8_t *data, size_t size) { m_data.insert(m_data.end(), data, data + size); }
+
+    const auto &data() const { return m_data; }
+    auto size() const { return m_data.size(); }
+    bool empty() const { return m_data.empty(); }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+/**
+ * @brief Code: The instructions of a function body, kept in memory until the function is
+ *        complete so that they can be improved as a whole before they are written out.
+ */
+class Code {
+public:
+    void emit(Op op, int64_t imm = 0, Symbol name = {}) { m_instrs.push_back({op, imm, name}); }
+
+    /**
+     * @brief peephole: Rewrites short sequences of instructions into cheaper equivalents: a
+     *        local.set followed by a local.get of the same local becomes a local.tee, arithmetic
+     *        with a constant that leaves the other operand as it is disappears and so do values
+     *        that are computed without an effect only to be dropped. Code following an
+     *        unconditional transfer of control up to the end of its block is removed.
+     * @return The number of instructions removed.
+     */
+    size_t peephole();
+
+    /**
+     * @brief write_text: The instructions in the text format, one per line.
+     */
+    void write_text(fmt::memory_buffer &out) const;
+
+    const auto &instrs() const { return m_instrs; }
+    auto size() const { return m_instrs.size(); }
+    bool empty() const { return m_instrs.empty(); }
+
+private:
+    std::vector<Instr> m_instrs;
+};
+
+/**
+ * @brief Locals: The local index space of a function body. Parameters come first, followed by the
+ *        locals in order of declaration. Each index remembers the Kiraz type it was last declared
+ *        with and the name of the local that first took it, which the text format refers to it by.
+ */
+class Locals {
+public:
+    /**
+     * @brief add_param, add_local: Names the next parameter, or declares a new local. All
+     *        parameters have to be added before the first local.
+     * @return The local index.
+     */
+    uint32_t add_param(Symbol name, const Type *type);
+
+    /**
+     * @param reuse: Whether the local can take the index of a released one of the same value type,
+     *        which it can if it is stored to before it is read.
+     */
+    uint32_t add_local(Symbol name, const Type *type, bool reuse = false);
+
+    /**
+     * @brief release: Makes the index of a local that is not used any more available to the
+     *        locals added after it. Parameters and indices that are already free are left alone.
+     */
+    void release(Symbol name);
+
+    std::optional<uint32_t> find(Symbol name) const;
+    const Type *get_type(uint32_t index) const { return m_types.at(index); }
+    ValType get_value_type(uint32_t index) const { return m_values.at(index); }
+    Symbol get_slot(uint32_t index) const { return m_slots.at(index); }
+    uint32_t get_param_count() const { return m_params; }
+
+    /**
+     * @brief get_declarations: Indices of the locals, parameters excluded, sorted by value type so
+     *        that their declarations form as few runs of the same type as there can be.
+     */
+    std::vector<uint32_t> get_declarations() const;
+
+private:
+    uint32_t add_index(Symbol name, const Type *type);
+
+    uint32_t m_params = 0;
+    std::vector<ValType> m_values;
+    std::vector<const Type *> m_types;
+    std::vector<Symbol> m_slots;
+    std::unordered_map<Symbol, uint32_t> m_names;
+    std::vector<uint32_t> m_free;
+};
+
+/**
+ * @brief FunctionBuilder: Locals and code of one function body. The body is encoded with the
+ *        locals sorted by value type, renumbering the references to them.
+ */
+class FunctionBuilder {
+public:
+    FunctionBuilder(uint32_t index, const Type *type);
+
+    /**
+     * @brief add_param: Names the next parameter, with its type from the signature.
+     * @return The local index.
+     */
+    uint32_t add_param(Symbol name);
+
+    /**
+     * @brief emit_local: Emits a local.get, local.set or local.tee of the local with the given
+     *        index.
+     */
+    void emit_local(Op op, uint32_t index) { m_code.emit(op, index, m_locals.get_slot(index)); }
+
+    Locals &locals() { return m_locals; }
+    Code &code() { return m_code; }
+    const auto &get_type() const { return m_type; }
+    auto get_result() const { return m_result; }
+    auto get_index() const { return m_index; }
+
+    /**
+     * @brief encode: Writes the size prefixed body, ie. an entry of the code section.
+     */
+    void encode(ByteBuffer &out) const;
+
+    /**
+     * @brief write_text: The parameters, result, locals and instructions of the function in the
+     *        text format, up to its closing parenthesis.
+     */
+    void write_text(fmt::memory_buffer &out) const;
+
+private:
+    uint32_t m_index;
+    FuncType m_type;
+    const Type *m_decl;
+    const Type *m_result;
+    Locals m_locals;
+    Code m_code;
+};
+
+/**
+ * @brief ModuleBuilder: Collects imports, functions and exports and encodes them as a module.
+ *        Imported functions occupy the start of the function index space, so all imports have
+ *        to be added before the first function is declared.
+ */
+class ModuleBuilder {
+public:
+    uint32_t add_type(const FuncType &type);
+    uint32_t add_import(std::string_view module, std::string_view name, const FuncType &type);
+
+    /**
+     * @brief declare_function: Reserves an index for a function defined in this module, so that
+     *        calls to it can be emitted before its body.
+     * @param type: Kiraz function type
+     */
+    uint32_t declare_function(Symbol name, const Type *type);
+    std::optional<uint32_t> find_function(Symbol name) const;
+    const FuncType &get_function_type(uint32_t index) const;
+
+    /**
+     * @brief get_function_decl: The Kiraz type of a function defined in this module.
+     */
+    const Type *get_function_decl(uint32_t index) const;
+
+    /**
+     * @brief begin_function: Starts the body of a declared function. It becomes the current one
+     *        until end_function().
+     */
+    FunctionBuilder &begin_function(uint32_t index);
+    void end_function();
+    FunctionBuilder &current();
+
+    /**
+     * @brief set_share_locals: Whether functions release their locals once they are dead, so that
+     *        locals that are not live at the same time share indices.
+     */
+    void set_share_locals(bool share) { m_share_locals = share; }
+    bool get_share_locals() const { return m_share_locals; }
+
+    /**
+     * @brief set_peephole: Whether the code of each function is run through Code::peephole()
+     *        when it ends.
+     */
+    void set_peephole(bool peephole) { m_peephole = peephole; }
+
+    void add_export(std::string_view name, ExternalKind kind, uint32_t index);
+
+    /**
+     * @brief encode: The complete module, starting with the magic number.
+     */
+    std::vector<uint8_t> encode() const;
+
+    /**
+     * @brief write_text: The complete module in the text format.
+     */
+    void write_text(fmt::memory_buffer &out) const;
+
+private:
+    struct Import {
+        std::string module;
+        std::string name;
+        uint32_t type;
+    };
+
+    struct Export {
+        std::string name;
+        ExternalKind kind;
+        uint32_t index;
+    };
+
+    void add_section(ByteBuffer &out, uint8_t id, const ByteBuffer &content) const;
+
+    std::vector<FuncType> m_types;
+    std::vector<Import> m_imports;
+    std::vector<uint32_t> m_functions; // type index per defined function
+    std::vector<const Type *> m_decls;
+    std::vector<Symbol> m_decl_names;
+    std::deque<std::optional<FunctionBuilder>> m_bodies; // stable, current() points into it
+    std::vector<Export> m_exports;
+    std::unordered_map<Symbol, uint32_t> m_names;
+    FunctionBuilder *m_current = nullptr;
+    bool m_share_locals = false;
+    bool m_peephole = false;
+};
+
+} // namespace wasm
+
+#endif // KIRAZ_WASM_BINARY_H
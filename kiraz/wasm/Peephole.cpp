@@ -0,0 +1,173 @@
+
+#include "Binary.h"
+
+#include <utility>
+#include <vector>
+
+namespace wasm {
+
+namespace {
+
+/**
+ * @brief is_push: Whether the instruction pushes a value without popping any or having an effect.
+ */
+bool is_push(Op op) {
+    return op == Op::LocalGet || op == Op::I32Const || op == Op::I64Const;
+}
+
+/**
+ * @brief is_pure_unary, is_pure_binary: Whether the instruction computes a value from one or two
+ *        operands without having an effect or trapping. Division traps on a zero divisor.
+ */
+bool is_pure_unary(Op op) {
+    return op == Op::I64Eqz || op == Op::I32WrapI64 || op == Op::I64ExtendI32S
+            || op == Op::I64ExtendI32U;
+}
+
+bool is_pure_binary(Op op) {
+    switch (op) {
+    case Op::I64Eq:
+    case Op::I64Ne:
+    case Op::I64LtS:
+    case Op::I64GtS:
+    case Op::I64LeS:
+    case Op::I64GeS:
+    case Op::I32Add:
+    case Op::I32Sub:
+    case Op::I32Mul:
+    case Op::I64Add:
+    case Op::I64Sub:
+    case Op::I64Mul:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief is_identity: Whether the given constant, as the right operand of op, leaves the left one
+ *        as it is.
+ */
+bool is_identity(const Instr &constant, Op op) {
+    if (constant.op == Op::I64Const) {
+        return ((op == Op::I64Add || op == Op::I64Sub) && constant.imm == 0)
+                || ((op == Op::I64Mul || op == Op::I64DivS) && constant.imm == 1);
+    }
+    if (constant.op == Op::I32Const) {
+        return ((op == Op::I32Add || op == Op::I32Sub) && constant.imm == 0)
+                || (op == Op::I32Mul && constant.imm == 1);
+    }
+    return false;
+}
+
+bool opens_block(Op op) {
+    return op == Op::Block || op == Op::Loop || op == Op::If;
+}
+
+/**
+ * @brief is_transfer: Whether control never reaches the instruction after this one.
+ */
+bool is_transfer(Op op) {
+    return op == Op::Br || op == Op::Return || op == Op::Unreachable;
+}
+
+/**
+ * @brief Rewriter: Appends instructions to a list, rewriting them with the end of the list as
+ *        they come. A rewrite can produce instructions that are rewritten in turn.
+ */
+class Rewriter {
+public:
+    explicit Rewriter(std::vector<Instr> &out) : m_out(out) {}
+
+    void push(const Instr &instr);
+
+private:
+    std::vector<Instr> &m_out;
+};
+
+void Rewriter::push(const Instr &instr) {
+    if (m_out.empty()) {
+        m_out.push_back(instr);
+        return;
+    }
+
+    auto &last = m_out.back();
+    if (last.op == Op::LocalSet && instr.op == Op::LocalGet && last.imm == instr.imm
+            && last.name == instr.name) {
+        last.op = Op::LocalTee;
+        return;
+    }
+
+    if (is_identity(last, instr.op)) {
+        m_out.pop_back();
+        return;
+    }
+
+    // i32.wrap_i64 undoes either extension, not the other way around
+    if (instr.op == Op::I32WrapI64
+            && (last.op == Op::I64ExtendI32S || last.op == Op::I64ExtendI32U)) {
+        m_out.pop_back();
+        return;
+    }
+
+    if (instr.op == Op::Drop) {
+        if (is_push(last.op)) {
+            m_out.pop_back();
+            return;
+        }
+        if (last.op == Op::LocalTee) {
+            last.op = Op::LocalSet;
+            return;
+        }
+
+        // the operands are dropped instead, which can remove them in turn
+        if (is_pure_unary(last.op) || is_pure_binary(last.op)) {
+            auto operands = is_pure_binary(last.op) ? 2 : 1;
+            m_out.pop_back();
+            for (int i = 0; i < operands; ++i) {
+                push(instr);
+            }
+            return;
+        }
+    }
+
+    m_out.push_back(instr);
+}
+
+} // namespace
+
+size_t Code::peephole() {
+    std::vector<Instr> out;
+    out.reserve(m_instrs.size());
+    Rewriter rewriter(out);
+
+    // nothing runs after an unconditional transfer up to the end of its block, or the else of its
+    // if; depth counts the blocks opened in between
+    bool dead = false;
+    size_t depth = 0;
+    for (const auto &instr : m_instrs) {
+        if (dead) {
+            if (opens_block(instr.op)) {
+                ++depth;
+                continue;
+            }
+            if (instr.op != Op::End && instr.op != Op::Else) {
+                continue;
+            }
+            if (depth > 0) {
+                depth -= instr.op == Op::End;
+                continue;
+            }
+            dead = false;
+        }
+
+        rewriter.push(instr);
+        dead = is_transfer(instr.op);
+    }
+
+    auto retval = m_instrs.size() - out.size();
+    m_instrs = std::move(out);
+    return retval;
+}
+
+} // namespace wasm
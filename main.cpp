@@ -1,12 +1,34 @@
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
 #include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 #include "lexer.hpp"
 #include "main.h"
 #include "parser.hpp"
 
+#include <kiraz/Compiler.h>
 #include <kiraz/Node.h>
+#include <kiraz/ParseContext.h>
+#include <kiraz/Server.h>
 #include <kiraz/ast/testModule.h>
 
 
@@ -24,10 +46,15 @@ enum Mode {
     MODE_HELP,
 };
 
+enum class Report {
+    None,
+    Text,
+    Json,
+};
+
 static int test(std::string_view str) {
-    auto buffer = yy_scan_string(str.data());
-    auto ret = yyparse();
-    yy_delete_buffer(buffer);
+    auto ret = ParseContext::current()->parse(str);
+    fmt::print("{}", ParseContext::current()->get_error());
 
     if (Node::current_root()) {
         fmt::print("{}\n", Node::current_root()->as_string());
@@ -38,7 +65,11 @@ static int test(std::string_view str) {
 
 static int usage(int argc, char **argv) {
     fmt::print("Usage: {} -s [string to parse] ....\n", argv[0]);
-    fmt::print("       {} -f [file to parse] ....\n", argv[0]);
+    fmt::print("       {} -f [files to compile] .... [-j jobs] [--wasm] [-O[level]] "
+               "[--entry=F[,G...]] [--inline-threshold=N] [--time-report[=json]]\n",
+            argv[0]);
+    fmt::print("       {} --server[=socket path] [--wasm] [-O[level]] [--entry=F[,G...]]\n",
+            argv[0]);
     fmt::print("       {} -h Show this help\n", argv[0]);
 
     return ERR;
@@ -52,26 +83,310 @@ static int handle_mode_text(std::string_view arg) {
     return OK;
 }
 
-static int handle_mode_file(std::string_view arg) {
-    fmt::print("TODO\n");
+/**
+ * @brief FileResult: The outcome of compiling one input file. Workers only fill in their own slot
+ *        so that diagnostics can be reported in input order once everyone is done.
+ */
+struct FileResult {
+    int status = OK;
+    std::string error;
+    std::string report;
+};
+
+static FileResult compile_file(const std::string &file_name, Compiler::Output output,
+        const opt::Options &optimize, Report report_format) {
+    FileResult retval;
+
+    Compiler compiler;
+    compiler.set_output(output);
+    compiler.set_optimize(optimize);
+
+    TimeReport report;
+    if (report_format != Report::None) {
+        compiler.set_report(&report);
+    }
+
+    auto status = compiler.compile_file(file_name);
+    if (report_format == Report::Text) {
+        retval.report = report.format_text(file_name);
+    } else if (report_format == Report::Json) {
+        retval.report = report.format_json(file_name);
+    }
+
+    retval.status = status;
+    if (retval.status != OK) {
+        retval.error = compiler.get_error();
+        return retval;
+    }
+
+    auto out_name = std::filesystem::path(file_name);
+    std::ofstream f;
+    if (output == Compiler::Output::Wasm) {
+        out_name.replace_extension(".wasm");
+        const auto &wasm = compiler.get_wasm();
+        f.open(out_name, std::ios::binary);
+        f.write(reinterpret_cast<const char *>(wasm.data()), wasm.size());
+    } else {
+        out_name.replace_extension(".wat");
+        f.open(out_name, std::ios::binary);
+        compiler.get_wasm_ctx().body().write(f);
+    }
+
+    if (! f) {
+        retval.status = ERR;
+        retval.error = FF("{}: could not write output\n", out_name.string());
+    }
+
+    return retval;
+}
+
+static int handle_mode_file(const std::vector<std::string> &files, unsigned jobs,
+        Compiler::Output output, const opt::Options &optimize, Report report) {
+    std::vector<FileResult> results(files.size());
+
+    // Each worker runs its own Compiler, picking the next file as soon as it is done with one.
+    std::atomic<size_t> next = 0;
+    auto worker = [&] {
+        for (size_t i; (i = next++) < files.size();) {
+            results[i] = compile_file(files[i], output, optimize, report);
+        }
+    };
+
+    jobs = std::clamp<size_t>(jobs, 1, files.size());
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < jobs; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    // text reports go with the diagnostics, the json one is a single document on stdout
+    if (report == Report::Json) {
+        fmt::print("[");
+        for (size_t i = 0; i < files.size(); ++i) {
+            fmt::print("{}\n{}", i ? "," : "", results[i].report);
+        }
+        fmt::print("\n]\n");
+    }
+
+    auto retval = OK;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (report == Report::Text) {
+            fmt::print(stderr, "{}", results[i].report);
+        }
+
+        if (results[i].status == OK) {
+            continue;
+        }
+
+        fmt::print(stderr, "{}", results[i].error);
+        retval = ERR;
+    }
+
+    return retval;
+}
+
+static bool parse_jobs(std::string_view arg, unsigned &jobs) {
+    auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), jobs);
+    return ec == std::errc() && ptr == arg.data() + arg.size() && jobs > 0;
+}
+
+/**
+ * @brief parse_entry_points: A comma separated list of function names.
+ */
+static bool parse_entry_points(std::string_view arg, opt::Options &optimize) {
+    for (size_t pos = 0; pos <= arg.size();) {
+        auto end = std::min(arg.find(',', pos), arg.size());
+        if (end == pos) {
+            return false;
+        }
+        optimize.entry_points.push_back(Symbol::intern(arg.substr(pos, end - pos)));
+        pos = end + 1;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief remove_stale_socket: Removes the socket a server that did not shut down cleanly left
+ *        behind at the given address, so that it can be bound again. A socket someone still
+ *        listens on is left alone.
+ */
+static void remove_stale_socket(const sockaddr_un &addr) {
+    struct stat st;
+    if (lstat(addr.sun_path, &st) != 0 || ! S_ISSOCK(st.st_mode)) {
+        return;
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0
+            && errno == ECONNREFUSED) {
+        unlink(addr.sun_path);
+    }
+    close(fd);
+}
+
+static int serve_socket(Compiler &compiler, const std::string &socket_path,
+        Compiler::Output output, const opt::Options &optimize) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        fmt::print(stderr, "{}: socket path too long\n", socket_path);
+        return ERR;
+    }
+    std::memcpy(addr.sun_path, socket_path.data(), socket_path.size());
+    remove_stale_socket(addr);
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+            || listen(fd, SOMAXCONN) != 0) {
+        fmt::print(stderr, "{}: {}\n", socket_path, std::strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return ERR;
+    }
+
+    // a client that goes away mid response must not take the server with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // clients are served one at a time, each for as long as it keeps its connection open
+    for (bool quit = false; ! quit;) {
+        auto conn = accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fmt::print(stderr, "{}: {}\n", socket_path, std::strerror(errno));
+            break;
+        }
+
+        auto in = fdopen(conn, "rb");
+        auto out = fdopen(dup(conn), "wb");
+        if (in && out) {
+            quit = server::serve(compiler, output, optimize, in, out);
+        }
+        if (out) {
+            std::fclose(out);
+        }
+        if (in) {
+            std::fclose(in);
+        } else {
+            close(conn);
+        }
+    }
+
+    close(fd);
+    unlink(socket_path.c_str());
+    return OK;
+}
+
+#endif
+
+static int handle_mode_server(
+        const std::string &socket_path, Compiler::Output output, const opt::Options &optimize) {
+    Compiler compiler;
+
+    if (socket_path.empty()) {
+        server::serve(compiler, output, optimize, stdin, stdout);
+        return OK;
+    }
+
+#ifdef _WIN32
+    fmt::print(stderr, "{}: serving on a socket is not supported on this platform\n", socket_path);
     return ERR;
+#else
+    return serve_socket(compiler, socket_path, output, optimize);
+#endif
 }
 
+
 int main(int argc, char **argv) {
     yydebug = 0;
 
+    ParseContext parser;
     static Mode mode = MODE_UNKNOWN;
 
     if (argc < 2) {
         return usage(argc, argv);
     }
 
+    std::vector<std::string> files;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    auto output = Compiler::Output::Wat;
+    auto report = Report::None;
+    opt::Options optimize;
+    std::optional<std::string> server;
+
     for (auto i = 1; i < argc; ++i) {
         Node::reset_root();
 
         std::string_view arg(argv[i]);
 
-        if (mode == MODE_UNKNOWN) {
+        if (arg == "--wasm") {
+            output = Compiler::Output::Wasm;
+            continue;
+        }
+
+        if (arg.starts_with("-O")) {
+            if (! opt::parse_level(arg.substr(2), optimize)) {
+                return usage(argc, argv);
+            }
+            continue;
+        }
+
+        if (arg.starts_with("--entry=")) {
+            if (! parse_entry_points(arg.substr(std::strlen("--entry=")), optimize)) {
+                return usage(argc, argv);
+            }
+            continue;
+        }
+
+        if (arg.starts_with("--inline-threshold=")) {
+            auto value = arg.substr(std::strlen("--inline-threshold="));
+            auto [ptr, ec] = std::from_chars(
+                    value.data(), value.data() + value.size(), optimize.inline_threshold);
+            if (ec != std::errc() || ptr != value.data() + value.size()
+                    || optimize.inline_threshold < 0) {
+                return usage(argc, argv);
+            }
+            continue;
+        }
+
+        if (arg == "--time-report") {
+            report = Report::Text;
+            continue;
+        }
+
+        if (arg == "--time-report=json") {
+            report = Report::Json;
+            continue;
+        }
+
+        if (arg == "--server") {
+            server.emplace();
+            continue;
+        }
+
+        if (arg.starts_with("--server=")) {
+            server.emplace(arg.substr(std::strlen("--server=")));
+            continue;
+        }
+
+        if (arg == "-j") {
+            if (++i == argc || ! parse_jobs(argv[i], jobs)) {
+                return usage(argc, argv);
+            }
+            continue;
+        }
+
+        if (mode == MODE_UNKNOWN || mode == MODE_FILE) {
             if (arg == "-f") {
                 mode = MODE_FILE;
                 continue;
@@ -94,10 +409,9 @@ int main(int argc, char **argv) {
             return usage(argc, argv);
 
         case MODE_FILE:
-            if (auto ret = handle_mode_file(argv[i]); ret != OK) {
-                return ret;
-            }
-            return 1;
+            // -f takes every argument up to the next option
+            files.emplace_back(arg);
+            continue;
 
         case MODE_TEXT:
             if (auto ret = handle_mode_text(argv[i]); ret != OK) {
@@ -109,9 +423,24 @@ int main(int argc, char **argv) {
         mode = MODE_UNKNOWN;
     }
 
-    if (mode != MODE_UNKNOWN) {
+    if (mode == MODE_FILE && files.empty()) {
+        return usage(argc, argv);
+    }
+
+    if (mode != MODE_UNKNOWN && mode != MODE_FILE) {
         return usage(argc, argv);
     }
 
+    if (server) {
+        if (! files.empty()) {
+            return usage(argc, argv);
+        }
+        return handle_mode_server(*server, output, optimize);
+    }
+
+    if (! files.empty()) {
+        return handle_mode_file(files, jobs, output, optimize, report);
+    }
+
     return 0;
 }
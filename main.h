@@ -7,7 +7,5 @@
 #include <fmt/ranges.h>
 
 class Node;
-extern "C" int yylex(void);
-#define YY_DECL int yylex(void)
-#define YYSTYPE std::shared_ptr<Node>
+#define YYSTYPE Node *
 #include "parser.hpp"
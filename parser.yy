@@ -1,20 +1,32 @@
+%code requires {
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+class ParseContext;
+}
+
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {ParseContext &ctx}
+
 %{
 #include "lexer.hpp"
 
+#include <kiraz/ParseContext.h>
+
 #include <kiraz/ast/Operator.h>
 #include <kiraz/ast/Literal.h>
 #include <kiraz/ast/LetNode.h>
 #include <kiraz/ast/FuncNode.h>
-#include <kiraz/token/keyword.h>
 #include <kiraz/token/Literal.h>
-#include <kiraz/token/Operator.h>
-#include <kiraz/token/FuncNode.h>
 #include <kiraz/ast/testModule.h>
 #include <kiraz/ast/KeyNodes.h>
 
-int yyerror(const char *msg);
-extern std::shared_ptr<Token> curtoken;
-extern int yylineno;
+int yyerror(yyscan_t scanner, ParseContext &ctx, const char *msg);
+
+// go through the context so that scanning can be timed
+#define yylex ParseContext::lex
 %}
 
 %token REJECTED
@@ -36,13 +48,12 @@ extern int yylineno;
 %%
 
 module:
-    stmt { 
-        $$ = Node::add<ast::Module>($1); 
-    }
-    stmt_list { 
-        $$ = Node::add<ast::Module>($1); 
+    stmt_list stmt {
+        auto stmts = cast<ast::NodeList>($1);
+        stmts->add_node($2);
+        $$ = ctx.add<ast::Module>(stmts);
     }
-    ;   
+    ;
 
 stmt:
     OP_LPAREN stmt OP_RPAREN { $$ = $2; }
@@ -62,53 +73,54 @@ expr:
     addsub
     | muldiv
     | posneg
-    | expr OP_EQ expr { $$ = Node::add<ast::OpEq>($1, $3); }
-    | expr OP_GT expr { $$ = Node::add<ast::OpGt>($1, $3); }
-    | expr OP_GE expr { $$ = Node::add<ast::OpGe>($1, $3); }
-    | expr OP_LT expr { $$ = Node::add<ast::OpLt>($1, $3); }
-    | expr OP_LE expr { $$ = Node::add<ast::OpLe>($1, $3); }
-    | expr OP_DOT IDENTIFIER { $$ = Node::add<ast::DotNode>($1, Node::add<ast::Identifier>(curtoken)); }
+    | expr OP_EQ expr { $$ = ctx.add<ast::OpEq>($1, $3); }
+    | expr OP_GT expr { $$ = ctx.add<ast::OpGt>($1, $3); }
+    | expr OP_GE expr { $$ = ctx.add<ast::OpGe>($1, $3); }
+    | expr OP_LT expr { $$ = ctx.add<ast::OpLt>($1, $3); }
+    | expr OP_LE expr { $$ = ctx.add<ast::OpLe>($1, $3); }
+    | expr OP_DOT IDENTIFIER { $$ = ctx.add<ast::DotNode>($1, ctx.add<ast::Identifier>(ctx.get_token())); }
     | call_expr
-    | L_INTEGER { $$ = Node::add<ast::Integer>(curtoken); }
-    | L_STRING { $$ = Node::add<ast::StringLiteral>(curtoken); }
+    | L_INTEGER { $$ = ctx.add<ast::Integer>(ctx.get_token()); }
+    | L_STRING { $$ = ctx.add<ast::StringLiteral>(ctx.get_token()); }
     | OP_LPAREN expr OP_RPAREN { $$ = $2; }
     | type
     ;
 
 addsub:
-    expr OP_PLUS expr { $$ = Node::add<ast::OpAdd>($1, $3); }
-    | expr OP_MINUS expr { $$ = Node::add<ast::OpSub>($1, $3); }
+    expr OP_PLUS expr { $$ = ctx.add<ast::OpAdd>($1, $3); }
+    | expr OP_MINUS expr { $$ = ctx.add<ast::OpSub>($1, $3); }
     ;
 
 muldiv:
-    expr OP_MULT expr { $$ = Node::add<ast::OpMult>($1, $3); }
-    | expr OP_DIVF expr { $$ = Node::add<ast::OpDivF>($1, $3); }
+    expr OP_MULT expr { $$ = ctx.add<ast::OpMult>($1, $3); }
+    | expr OP_DIVF expr { $$ = ctx.add<ast::OpDivF>($1, $3); }
     ;
 
 posneg:
-    OP_PLUS selection { $$ = Node::add<ast::SignedNode>(OP_PLUS, $2); }
-    | OP_MINUS selection { $$ = Node::add<ast::SignedNode>(OP_MINUS, $2); }
+    OP_PLUS selection { $$ = ctx.add<ast::SignedNode>(OP_PLUS, $2); }
+    | OP_MINUS selection { $$ = ctx.add<ast::SignedNode>(OP_MINUS, $2); }
     ;
 
 selection:
-     L_INTEGER { $$ = Node::add<ast::Integer>(curtoken); }
+     L_INTEGER { $$ = ctx.add<ast::Integer>(ctx.get_token()); }
     | OP_LPAREN expr OP_RPAREN { $$ = $2; }
     ;
 
 call_expr:
     expr OP_LPAREN call_arg_list OP_RPAREN {
-        $$ = Node::add<ast::CallNode>($1, $3); 
+        $$ = ctx.add<ast::CallNode>($1, $3); 
     }
     ;
 
 call_arg_list:
+    { $$ = ctx.add<ast::FuncArgs>(); }
     | expr { 
-        auto args = Node::add<ast::FuncArgs>(); 
+        auto args = ctx.add<ast::FuncArgs>(); 
         args->add_argument($1); 
         $$ = args; 
     }
     | call_arg_list OP_COMMA expr { 
-        auto args = std::dynamic_pointer_cast<ast::FuncArgs>($1); 
+        auto args = dyn_cast<ast::FuncArgs>($1); 
         if (args) {
             args->add_argument($3); 
         }
@@ -117,12 +129,12 @@ call_arg_list:
     ;
 
 return_stmt:
-    KW_RETURN expr OP_SCOLON { $$ = Node::add<ast::ReturnNode>($2); }
+    KW_RETURN expr OP_SCOLON { $$ = ctx.add<ast::ReturnNode>($2); }
 ;
 
 combined_stmt:
     import_stmt OP_SCOLON class_stmt OP_SCOLON {
-        auto module_node = Node::add<ast::Combined>();
+        auto module_node = ctx.add<ast::Combined>();
         module_node->add_node($1);  
         module_node->add_node($3);
         $$ = module_node;
@@ -131,110 +143,110 @@ combined_stmt:
 
 class_stmt:
     KW_CLASS type OP_COLON type OP_LBRACE reverse_stmt_list OP_RBRACE {
-        $$ = Node::add<ast::ClassNode>($2, $4, $6);
+        $$ = ctx.add<ast::ClassNode>($2, $6, $4);
     }
     | KW_CLASS type OP_LBRACE reverse_stmt_list OP_RBRACE {
-        $$ = Node::add<ast::ClassNode>($2, $4); 
+        $$ = ctx.add<ast::ClassNode>($2, $4); 
     }
     ;
 
 if_stmt:
     KW_IF OP_LPAREN expr OP_RPAREN OP_LBRACE reverse_stmt_list OP_RBRACE {
-        $$ = Node::add<ast::IfNode>($3, $6, nullptr); 
+        $$ = ctx.add<ast::IfNode>($3, $6, nullptr); 
     }
     | KW_IF OP_LPAREN expr OP_RPAREN OP_LBRACE reverse_stmt_list OP_RBRACE KW_ELSE OP_LBRACE reverse_stmt_list OP_RBRACE {
-        $$ = Node::add<ast::IfNode>($3, $6, $10);
+        $$ = ctx.add<ast::IfNode>($3, $6, $10);
     }
     | KW_IF OP_LPAREN expr OP_RPAREN OP_LBRACE reverse_stmt_list OP_RBRACE KW_ELSE if_stmt {
-        $$ = Node::add<ast::IfNode>($3, $6, $9);
+        $$ = ctx.add<ast::IfNode>($3, $6, $9);
     }
     ;
 
 while_stmt:
     KW_WHILE OP_LPAREN expr OP_RPAREN OP_LBRACE stmt_list OP_RBRACE {
-        $$ = Node::add<ast::WhileNode>($3, $6);
+        $$ = ctx.add<ast::WhileNode>($3, $6);
     }
     ;
 
 import_stmt:
     KW_IMPORT type {
-        $$ = Node::add<ast::ImportNode>($2);
+        $$ = ctx.add<ast::ImportNode>($2);
     }
     ;
 
 assign_stmt: 
-    expr OP_ASSIGN expr { $$ = Node::add<ast::AssignNode>($1, $3); }
+    expr OP_ASSIGN expr { $$ = ctx.add<ast::AssignNode>($1, $3); }
 
 func_stmt:
     KW_FUNC type OP_LPAREN arg_list OP_RPAREN OP_COLON type OP_LBRACE stmt_list OP_RBRACE OP_SCOLON {
-        $$ = Node::add<ast::FuncNode>($2, $4, $7, $9);
+        $$ = ctx.add<ast::FuncNode>($2, $4, $7, $9);
     }
     ;
 
 arg_list:
     type OP_COLON type {
-        auto args = Node::add<ast::FuncArgs>();
-        args->add_argument(Node::add<ast::ArgNode>($1, $3));  
+        auto args = ctx.add<ast::FuncArgs>();
+        args->add_argument(ctx.add<ast::ArgNode>($1, $3));  
         $$ = args;
     }
     | arg_list OP_COMMA type OP_COLON type {
-        auto args = std::dynamic_pointer_cast<ast::FuncArgs>($1);
+        auto args = dyn_cast<ast::FuncArgs>($1);
         if (args) {
-            args->add_argument(Node::add<ast::ArgNode>($3, $5)); 
+            args->add_argument(ctx.add<ast::ArgNode>($3, $5)); 
         }
         $$ = $1;
     }
     | {
-        $$ = Node::add<ast::FuncArgs>();
+        $$ = ctx.add<ast::FuncArgs>();
     }
     ;
 
 stmt_list:
-    { $$ = Node::add<ast::NodeList>(); }
-    | stmt stmt_list {
-        auto stmts = std::dynamic_pointer_cast<ast::NodeList>($2);
-        stmts->add_node($1);
+    { $$ = ctx.add<ast::NodeList>(); }
+    | stmt_list stmt {
+        auto stmts = cast<ast::NodeList>($1);
+        stmts->add_node($2);
         $$ = stmts;
     }
     ;
 
 reverse_stmt_list:
-    { $$ = Node::add<ast::NodeList>(); }
+    { $$ = ctx.add<ast::NodeList>(); }
     | stmt { 
-        auto stmts = Node::add<ast::NodeList>();
+        auto stmts = ctx.add<ast::NodeList>();
         stmts->add_node($1);
         $$ = stmts;
     }
     | reverse_stmt_list stmt {
-        auto stmts = std::dynamic_pointer_cast<ast::NodeList>($1);
+        auto stmts = cast<ast::NodeList>($1);
         stmts->add_node($2);
         $$ = stmts;
     }
     ;
 
 let_stmt:
-    KW_LET type OP_ASSIGN expr OP_SCOLON { $$ = Node::add<ast::LetNode>($2, nullptr, $4); }
-    | KW_LET type OP_COLON type OP_SCOLON { $$ = Node::add<ast::LetNode>($2, $4, nullptr); }
-    | KW_LET type OP_COLON type OP_ASSIGN expr OP_SCOLON { $$ = Node::add<ast::LetNode>($2, $4, $6); }
+    KW_LET type OP_ASSIGN expr OP_SCOLON { $$ = ctx.add<ast::LetNode>($2, nullptr, $4); }
+    | KW_LET type OP_COLON type OP_SCOLON { $$ = ctx.add<ast::LetNode>($2, $4, nullptr); }
+    | KW_LET type OP_COLON type OP_ASSIGN expr OP_SCOLON { $$ = ctx.add<ast::LetNode>($2, $4, $6); }
     ;
 
 type:
-    IDENTIFIER { $$ = Node::add<ast::Identifier>(curtoken); }
+    IDENTIFIER { $$ = ctx.add<ast::Identifier>(ctx.get_token()); }
     ;
 
 %%
 
-int yyerror(const char *s) {
-    if (curtoken) {
-        fmt::print("** Parser Error at {}:{} at token: {}\n",
-            yylineno, Token::colno, curtoken->as_string());
+int yyerror(yyscan_t scanner, ParseContext &ctx, const char *s) {
+    if (ctx.get_token()) {
+        ctx.add_error(FF("** Parser Error at {}:{} at token: {}\n",
+            ctx.get_line(), ctx.colno, ctx.get_token().as_string()));
     } else {
-        fmt::print("** Parser Error at {}:{}, null token\n",
-            yylineno, Token::colno);
+        ctx.add_error(FF("** Parser Error at {}:{}, null token\n",
+            ctx.get_line(), ctx.colno));
     }
 
-    Token::colno = 0;
-    Node::reset_root();
+    ctx.colno = 0;
+    ctx.reset_root();
 
     return 1;
-}
\ No newline at end of file
+}
@@ -27,6 +27,31 @@ add_executable(test_semantics kiraz/test/test_semantics.cc)
 target_link_libraries(test_semantics kiraz GTest::gtest_main ${FLEX_LIBRARIES})
 gtest_discover_tests(test_semantics)
 
+# test_wasm
+add_executable(test_wasm kiraz/test/test_wasm.cc)
+target_link_libraries(test_wasm kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+gtest_discover_tests(test_wasm)
+
+# test_server
+add_executable(test_server kiraz/test/test_server.cc)
+target_link_libraries(test_server kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+gtest_discover_tests(test_server)
+
+# test_prelude
+add_executable(test_prelude kiraz/test/test_prelude.cc)
+target_link_libraries(test_prelude kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+gtest_discover_tests(test_prelude)
+
+# test_driver
+add_executable(test_driver kiraz/test/test_driver.cc)
+target_link_libraries(test_driver kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+gtest_discover_tests(test_driver)
+
+# test_types
+add_executable(test_types kiraz/test/test_types.cc)
+target_link_libraries(test_types kiraz GTest::gtest_main ${FLEX_LIBRARIES})
+gtest_discover_tests(test_types)
+
 
 # test_wasmgen
 option(KIRAZ_TEST_WASMGEN "Enable wasmgen tests" TRUE)